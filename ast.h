@@ -5,6 +5,7 @@
 #include <vector>
 #include <string>
 #include "lexer.h"
+#include "ast_arena.h"
 
 using namespace std;
 
@@ -48,10 +49,25 @@ enum NodeType {
     NODE_SmallFor,
 };
 
+/*类型名加上 Array 后缀；类型名都是字符串字面量，结点直接保存 string_view*/
+inline string_view arrayType(string_view type) {
+    if (type == "Int") return "IntArray";
+    if (type == "Char") return "CharArray";
+    if (type == "ConstInt") return "ConstIntArray";
+    if (type == "ConstChar") return "ConstCharArray";
+    return "Array";
+}
+
+/*语义分析填写的变量位置，代码生成据此写出 G<n>/L<n>；slot 为 -1 表示名字没有解析到*/
+struct SlotRef {
+    int slot = -1;
+    bool global = false;
+};
+
+/*结点都由 AstArena::make 创建，子结点指针不拥有所指结点，析构函数不会被调用*/
 class ASTNode {
 public:
     ASTNode(NodeType type) : type(type) {}
-    virtual ~ASTNode() {}
 
     NodeType type;
 };
@@ -59,9 +75,9 @@ public:
 class CompUnitNode : public ASTNode {
 public:
     CompUnitNode() : ASTNode(NODE_COMPUNIT) {}
-    vector<unique_ptr<ASTNode>> decls;
-    vector<unique_ptr<ASTNode>> funcDefs;
-    unique_ptr<ASTNode> mainFuncDef;
+    AstList<ASTNode*> decls;
+    AstList<ASTNode*> funcDefs;
+    ASTNode* mainFuncDef = nullptr;
 };
 
 class DeclNode : public ASTNode {
@@ -72,59 +88,62 @@ public:
 class ConstDeclNode : public DeclNode {
 public:
     ConstDeclNode() : DeclNode(NODE_CONSTDECL) {}
-    vector<unique_ptr<ASTNode>> constDefs;
+    AstList<ASTNode*> constDefs;
 };
 
 class ConstDefNode : public ASTNode {
 public:
     ConstDefNode() : ASTNode(NODE_CONSTDEF) {}
-    string name;
-    string constdeftype;
+    IdentId name; //identifiers 中的编号
+    string_view constdeftype;
     int linenum;
-    vector<unique_ptr<ASTNode>> initVals;
-    unique_ptr<ASTNode> arraysize;
+    AstList<ASTNode*> initVals;
+    ASTNode* arraysize = nullptr;
+    SlotRef ref; //语义分析分配的槽位
     int value_int;
-    string value_str;
+    string_view value_str;
 };
 
 class VarDeclNode : public DeclNode {
 public:
     VarDeclNode() : DeclNode(NODE_VARDECL) {}
-    vector<unique_ptr<ASTNode>> varDefs;
+    AstList<ASTNode*> varDefs;
 };
 
 class VarDefNode : public ASTNode {
 public:
     VarDefNode() : ASTNode(NODE_VARDEF) {}
-    string name;
-    string vardeftype;
+    IdentId name; //identifiers 中的编号
+    string_view vardeftype;
     int linenum;
-    vector<unique_ptr<ASTNode>> initVals;
-    unique_ptr<ASTNode> arraysize;
+    AstList<ASTNode*> initVals;
+    ASTNode* arraysize = nullptr;
+    SlotRef ref; //语义分析分配的槽位
 };
 
 class FuncDefNode : public ASTNode {
 public:
     FuncDefNode() : ASTNode(NODE_FUNCDEF) {}
-    string name;
-    string funcdeftype;
+    IdentId name; //identifiers 中的编号
+    string_view funcdeftype;
     int linenum;
-    unique_ptr<ASTNode> block;
-    unique_ptr<ASTNode> params; // 新增的成员
+    ASTNode* block = nullptr;
+    ASTNode* params = nullptr; // 新增的成员
 };
 
 class MainFuncDefNode : public ASTNode {
 public:
     MainFuncDefNode() : ASTNode(NODE_MAINFUNCDEF) {}
-    unique_ptr<ASTNode> block;
+    ASTNode* block = nullptr;
 };
 
 class BlockNode : public ASTNode {
 public:
     BlockNode() : ASTNode(NODE_BLOCK) {}
-    vector<unique_ptr<ASTNode>> stmts;
+    AstList<ASTNode*> stmts;
     int end_linenum;
     bool isfor;
+    AstList<SlotRef> popVars; //块结束时 POP_VAR 的变量，语义分析填写
 };
 
 class StmtNode : public ASTNode {
@@ -149,12 +168,15 @@ public:
 class LValNode : public ASTNode {
 public:
     LValNode() : ASTNode(NODE_LVAL) {}
-    string name;
+    IdentId name; //identifiers 中的编号
     //string lvaltype;
     int linenum;
     bool maybeisarray = true;
-    unique_ptr<ASTNode> indice;
+    ASTNode* indice = nullptr;
+    SlotRef ref; //语义分析解析到的变量
+    const ConstDefNode* constDef = nullptr; //解析到常量时指向它的定义，供常量传播
     int val;
+    bool isConst = false; //常量折叠填写，为真时 val 是作为右值的值
 };
 
 class PrimaryExpNode : public ASTNode {
@@ -170,64 +192,71 @@ public:
     UnaryExpNode() : ASTNode(NODE_UNARYEXP) {}
     // 一元表达式的具体内容
     TokenType unaryop;
-    unique_ptr<ASTNode> unaryexp;
+    ASTNode* unaryexp = nullptr;
     int val;
+    bool isConst = false; //常量折叠填写，为真时 val 是表达式的值
 };
 
 class FuncRParamsNode : public ASTNode {
 public:
     FuncRParamsNode() : ASTNode(NODE_FUNCRPARAMS) {}
-    vector<unique_ptr<ASTNode>> params;
-    string name;//函数名
+    AstList<ASTNode*> params;
+    IdentId name;//函数名
     int linenum;
 };
 
 class MulExpNode : public ASTNode {
 public:
     MulExpNode() : ASTNode(NODE_MULEXP) {}
-    vector<unique_ptr<ASTNode>> operands;
-    vector<TokenType> operators;
+    AstList<ASTNode*> operands;
+    AstList<TokenType> operators;
     int val;
+    bool isConst = false; //常量折叠填写，为真时 val 是表达式的值
 };
 
 class AddExpNode : public ASTNode {
 public:
     AddExpNode() : ASTNode(NODE_ADDEXP) {}
-    vector<unique_ptr<ASTNode>> operands;
-    vector<TokenType> operators;
+    AstList<ASTNode*> operands;
+    AstList<TokenType> operators;
     int val;
+    bool isConst = false; //常量折叠填写，为真时 val 是表达式的值
 };
 
 class RelExpNode : public ASTNode {
 public:
     RelExpNode() : ASTNode(NODE_RELEXP) {}
-    vector<unique_ptr<ASTNode>> operands;
-    vector<TokenType> operators;
+    AstList<ASTNode*> operands;
+    AstList<TokenType> operators;
     int val;
+    bool isConst = false; //常量折叠填写，为真时 val 是表达式的值
 };
 
 class EqExpNode : public ASTNode {
 public:
     EqExpNode() : ASTNode(NODE_EQEXP) {}
-    vector<unique_ptr<ASTNode>> operands;
-    vector<TokenType> operators;
+    AstList<ASTNode*> operands;
+    AstList<TokenType> operators;
     int val;
+    bool isConst = false; //常量折叠填写，为真时 val 是表达式的值
 };
 
 class LandExpNode : public ASTNode {
 public:
     LandExpNode() : ASTNode(NODE_LANDEXP) {}
-    vector<unique_ptr<ASTNode>> operands;
-    vector<TokenType> operators;
+    AstList<ASTNode*> operands;
+    AstList<TokenType> operators;
     int val;
+    bool isConst = false; //常量折叠填写，为真时 val 是表达式的值
 };
 
 class LorExpNode : public ASTNode {
 public:
     LorExpNode() : ASTNode(NODE_LOREXP) {}
-    vector<unique_ptr<ASTNode>> operands;
-    vector<TokenType> operators;
+    AstList<ASTNode*> operands;
+    AstList<TokenType> operators;
     int val;
+    bool isConst = false; //常量折叠填写，为真时 val 是表达式的值
 };
 
 class NumberNode : public ASTNode {
@@ -239,7 +268,7 @@ public:
 class CharacterNode : public ASTNode {
 public:
     CharacterNode() : ASTNode(NODE_CHARACTER) {}
-    string value;
+    string_view value;
 };
 
 class ConstExpNode : public ASTNode {
@@ -253,7 +282,7 @@ class ReturnStmtNode : public ASTNode {
 public:
     ReturnStmtNode() : ASTNode(NODE_RETURNSTMT) {}
     int linenum;
-    unique_ptr<ASTNode> exp;  // 返回的表达式
+    ASTNode* exp = nullptr;  // 返回的表达式
 };
 
 class BreakStmtNode : public ASTNode {
@@ -271,8 +300,8 @@ public:
 class PrintfStmtNode : public ASTNode {
 public:
     PrintfStmtNode() : ASTNode(NODE_PRINTFSTMT) {}
-    string format;
-    vector<unique_ptr<ASTNode>> args;
+    string_view format;
+    AstList<ASTNode*> args;
     int printlinenum;
 };
 
@@ -284,58 +313,161 @@ public:
 class AssignStmtNode : public ASTNode {
 public:
     AssignStmtNode() : ASTNode(NODE_ASSIGNSTMT) {}
-    unique_ptr<ASTNode> lval;
-    unique_ptr<ASTNode> exp;
-    bool getint;
-    bool getchar;
+    ASTNode* lval = nullptr;
+    ASTNode* exp = nullptr;
+    bool getint = false;
+    bool getchar = false;
 };
 
 class ExpStmtNode : public ASTNode {
 public:
     ExpStmtNode() : ASTNode(NODE_EXPSTMT) {}
-    unique_ptr<ASTNode> exp;
+    ASTNode* exp = nullptr;
     bool unable;
 };
 
 class IfStmtNode : public ASTNode {
 public:
     IfStmtNode() : ASTNode(NODE_IFSTMT) {}
-    unique_ptr<ASTNode> ifcond;
-    unique_ptr<ASTNode> thenStmt;
-    unique_ptr<ASTNode> elseStmt;
+    ASTNode* ifcond = nullptr;
+    ASTNode* thenStmt = nullptr;
+    ASTNode* elseStmt = nullptr;
     bool shortval;
 };
 
 class ForNode : public ASTNode { //总的for
 public:
     ForNode() : ASTNode(NODE_FOR) {}
-    unique_ptr<ASTNode> init;
-    unique_ptr<ASTNode> forcond;
-    unique_ptr<ASTNode> step;
-    unique_ptr<ASTNode> body;
+    ASTNode* init = nullptr;
+    ASTNode* forcond = nullptr;
+    ASTNode* step = nullptr;
+    ASTNode* body = nullptr;
 };
 
 class SmallforstmtNode : public ASTNode { //总的for
 public:
     SmallforstmtNode() : ASTNode(NODE_SmallFor) {}
-    unique_ptr<ASTNode> lval;
-    unique_ptr<ASTNode> exp;
+    ASTNode* lval = nullptr;
+    ASTNode* exp = nullptr;
 };
 
 class FuncFParamNode : public ASTNode { //形参
 public:
     FuncFParamNode() : ASTNode(NODE_FUNCFPARAM) {}
     TokenType type; // INTTK or CHARTK
-    string realtype;
-    string name;
+    string_view realtype;
+    IdentId name; //identifiers 中的编号
     int linenum;
     bool isArray;
+    SlotRef ref; //语义分析分配的槽位
 };
 
 class FuncFParamsNode : public ASTNode {   //函数名
 public:
     FuncFParamsNode() : ASTNode(NODE_FUNCFPARAMS) {}
-    vector<unique_ptr<ASTNode>> params;
+    AstList<ASTNode*> params;
+};
+
+/*
+ * 按固定顺序对结点的每个子结点调用 f(const ASTNode*)，可选的子结点不存在时传 nullptr
+ * 顺序：CompUnit 为 decls、funcDefs、mainFuncDef；Const/VarDef 为 arraysize、initVals；
+ * FuncDef 为 params、block；IfStmt 为 ifcond、thenStmt、elseStmt；For 为 init、forcond、step、body；
+ * AssignStmt、SmallFor 为 lval、exp；其余为唯一的子结点或子结点表
+ */
+template <typename F>
+void visitChildren(const ASTNode* node, F&& f) {
+    auto each = [&](const AstList<ASTNode*>& list) {
+        for (const ASTNode* child : list) {
+            f(child);
+        }
+    };
+    switch (node->type) {
+        case NODE_COMPUNIT: {
+            auto n = static_cast<const CompUnitNode*>(node);
+            each(n->decls);
+            each(n->funcDefs);
+            f(n->mainFuncDef);
+            break;
+        }
+        case NODE_CONSTDECL: each(static_cast<const ConstDeclNode*>(node)->constDefs); break;
+        case NODE_VARDECL: each(static_cast<const VarDeclNode*>(node)->varDefs); break;
+        case NODE_CONSTDEF: {
+            auto n = static_cast<const ConstDefNode*>(node);
+            f(n->arraysize);
+            each(n->initVals);
+            break;
+        }
+        case NODE_VARDEF: {
+            auto n = static_cast<const VarDefNode*>(node);
+            f(n->arraysize);
+            each(n->initVals);
+            break;
+        }
+        case NODE_FUNCDEF: {
+            auto n = static_cast<const FuncDefNode*>(node);
+            f(n->params);
+            f(n->block);
+            break;
+        }
+        case NODE_FUNCFPARAMS: each(static_cast<const FuncFParamsNode*>(node)->params); break;
+        case NODE_MAINFUNCDEF: f(static_cast<const MainFuncDefNode*>(node)->block); break;
+        case NODE_BLOCK: each(static_cast<const BlockNode*>(node)->stmts); break;
+        case NODE_LVAL: f(static_cast<const LValNode*>(node)->indice); break;
+        case NODE_UNARYEXP: f(static_cast<const UnaryExpNode*>(node)->unaryexp); break;
+        case NODE_FUNCRPARAMS: each(static_cast<const FuncRParamsNode*>(node)->params); break;
+        case NODE_MULEXP: each(static_cast<const MulExpNode*>(node)->operands); break;
+        case NODE_ADDEXP: each(static_cast<const AddExpNode*>(node)->operands); break;
+        case NODE_RELEXP: each(static_cast<const RelExpNode*>(node)->operands); break;
+        case NODE_EQEXP: each(static_cast<const EqExpNode*>(node)->operands); break;
+        case NODE_LANDEXP: each(static_cast<const LandExpNode*>(node)->operands); break;
+        case NODE_LOREXP: each(static_cast<const LorExpNode*>(node)->operands); break;
+        case NODE_RETURNSTMT: f(static_cast<const ReturnStmtNode*>(node)->exp); break;
+        case NODE_PRINTFSTMT: each(static_cast<const PrintfStmtNode*>(node)->args); break;
+        case NODE_ASSIGNSTMT: {
+            auto n = static_cast<const AssignStmtNode*>(node);
+            f(n->lval);
+            f(n->exp);
+            break;
+        }
+        case NODE_EXPSTMT: f(static_cast<const ExpStmtNode*>(node)->exp); break;
+        case NODE_IFSTMT: {
+            auto n = static_cast<const IfStmtNode*>(node);
+            f(n->ifcond);
+            f(n->thenStmt);
+            f(n->elseStmt);
+            break;
+        }
+        case NODE_FOR: {
+            auto n = static_cast<const ForNode*>(node);
+            f(n->init);
+            f(n->forcond);
+            f(n->step);
+            f(n->body);
+            break;
+        }
+        case NODE_SmallFor: {
+            auto n = static_cast<const SmallforstmtNode*>(node);
+            f(n->lval);
+            f(n->exp);
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+/*可修改子结点的版本，供改写语法树的遍历使用*/
+template <typename F>
+void visitChildren(ASTNode* node, F&& f) {
+    visitChildren(static_cast<const ASTNode*>(node), [&](const ASTNode* child) {
+        f(const_cast<ASTNode*>(child));
+    });
+}
+
+/*一次编译的语法树：结点都在 arena 里，随 arena 整体释放*/
+struct SyntaxTree {
+    unique_ptr<AstArena> arena;
+    ASTNode* root = nullptr;
 };
 
 #endif // AST_H
\ No newline at end of file
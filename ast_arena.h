@@ -0,0 +1,94 @@
+#ifndef AST_ARENA_H
+#define AST_ARENA_H
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+/*
+ * 语法树的内存池：结点、结点里的子结点表和文字都按顺序放进大块内存，
+ * 不单独释放，整棵树随 AstArena 一起按块释放。
+ * 结点的析构函数不会被调用，所以结点成员不能持有 arena 以外的内存。
+ */
+class AstArena {
+public:
+    AstArena() = default;
+    AstArena(const AstArena&) = delete;
+    AstArena& operator=(const AstArena&) = delete;
+
+    void* allocate(size_t size, size_t align) {
+        size_t offset = (used + align - 1) & ~(align - 1);
+        if (blocks.empty() || offset + size > capacity) {
+            capacity = size > blockSize ? size : blockSize;
+            blocks.emplace_back(new char[capacity]);
+            reserved += capacity;
+            offset = 0;
+        }
+        used = offset + size;
+        allocated += size;
+        return blocks.back().get() + offset;
+    }
+
+    /*构造期间 current 指向本 arena，结点里的 AstList 成员从这里分配*/
+    template <typename T, typename... Args>
+    T* make(Args&&... args) {
+        void* memory = allocate(sizeof(T), alignof(T));
+        AstArena* outer = current;
+        current = this;
+        T* node = new (memory) T(std::forward<Args>(args)...);
+        current = outer;
+        return node;
+    }
+
+    string_view copy(string_view text) {
+        char* data = (char*)allocate(text.size(), 1);
+        text.copy(data, text.size());
+        return string_view(data, text.size());
+    }
+
+    size_t bytesAllocated() const { return allocated; }
+    size_t bytesReserved() const { return reserved; }
+
+    static inline thread_local AstArena* current = nullptr;
+
+private:
+    static constexpr size_t blockSize = 64 * 1024;
+
+    vector<unique_ptr<char[]>> blocks;
+    size_t capacity = 0;
+    size_t used = 0;
+    size_t allocated = 0;
+    size_t reserved = 0;
+};
+
+/*从构造时所在的 arena 分配，释放是空操作；旧的缓冲在扩容后留在 arena 里直到整体释放*/
+template <typename T>
+class ArenaAllocator {
+public:
+    typedef T value_type;
+
+    ArenaAllocator() : arena(AstArena::current) {}
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) : arena(other.arena) {}
+
+    T* allocate(size_t n) { return (T*)arena->allocate(n * sizeof(T), alignof(T)); }
+    void deallocate(T*, size_t) {}
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U>& other) const { return arena == other.arena; }
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U>& other) const { return arena != other.arena; }
+
+    AstArena* arena;
+};
+
+/*结点里的子结点表*/
+template <typename T>
+using AstList = vector<T, ArenaAllocator<T>>;
+
+#endif // AST_ARENA_H
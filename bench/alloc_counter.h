@@ -0,0 +1,58 @@
+#ifndef ALLOC_COUNTER_H
+#define ALLOC_COUNTER_H
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+/*
+ * 统计堆分配：替换全局 operator new/delete，记录次数、字节数和峰值
+ * 定义了全局运算符，每个基准程序只能在一个源文件里包含
+ */
+struct AllocStats {
+    size_t count = 0;
+    size_t bytes = 0;
+    size_t live = 0;
+    size_t peak = 0;
+};
+
+inline AllocStats allocStats;
+
+// 分配块前放一个头记录大小，对齐到 max_align_t
+static constexpr size_t allocHeader = alignof(std::max_align_t);
+
+void* operator new(std::size_t size) {
+    char* block = (char*)std::malloc(size + allocHeader);
+    if (!block) {
+        throw std::bad_alloc();
+    }
+    *(size_t*)block = size;
+    allocStats.count++;
+    allocStats.bytes += size;
+    allocStats.live += size;
+    if (allocStats.live > allocStats.peak) {
+        allocStats.peak = allocStats.live;
+    }
+    return block + allocHeader;
+}
+
+void operator delete(void* ptr) noexcept {
+    if (ptr) {
+        char* block = (char*)ptr - allocHeader;
+        allocStats.live -= *(size_t*)block;
+        std::free(block);
+    }
+}
+
+void* operator new[](std::size_t size) { return operator new(size); }
+void operator delete[](void* ptr) noexcept { operator delete(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { operator delete(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { operator delete(ptr); }
+
+// 从当前开始重新统计，peak 以当前仍存活的字节为起点
+inline void resetAllocStats() {
+    allocStats.count = allocStats.bytes = 0;
+    allocStats.peak = allocStats.live;
+}
+
+#endif // ALLOC_COUNTER_H
@@ -0,0 +1,60 @@
+#include "bench_util.h"
+#include "pcode_interpreter.h"
+#include <algorithm>
+#include <cstdio>
+
+/*
+ * 数组传参：对 size 个元素的数组循环调用 calls 次 first(a)。
+ * 数组实参只传视图，每次调用的耗时应与数组大小无关。
+ */
+
+static std::string makeProgram(int size, int calls) {
+    std::ostringstream code;
+    code << "DEF_VAR IntArray G0 arr\n" << "PUSH " << size << "\n" << "STORE_arraysize G0\n"
+         << "FUNC_DEF first\n" << "JUMP firstEND_FUNC\n"
+         << "DEF_VAR IntArray L0 a\n" << "STORE_funcf_arraysize L0\n" << "LOAD_ARRPARAM 0 L0\n"
+         << "FUNCBLOCKNOW\n"
+         << "PUSH 0\n" << "STORE_arrayindex\n" << "LOAD_arrayelement L0 -1\n" << "RETURN\n"
+         << "LABEL firstEND_FUNC\n" << "END_FUNC\n"
+         << "FUNC_DEF main\n"
+         << "DEF_VAR Int L0 i\n" << "DEF_VAR Int L1 s\n"
+         << "PUSH 0\n" << "STORE L0\n"
+         << "LABEL LOOP\n"
+         << "LOAD L0\n" << "PUSH " << calls << "\n" << "LT\n" << "JUMP_IF_FALSE LOOP_END\n"
+         << "LOAD L1\n" << "LOAD G0\n" << "CALL first\n" << "ADD\n" << "STORE L1\n"
+         << "LOAD L0\n" << "PUSH 1\n" << "ADD\n" << "STORE L0\n"
+         << "JUMP LOOP\n"
+         << "LABEL LOOP_END\n"
+         << "LABEL mainEND_FUNC\n" << "END_FUNC\n";
+    return code.str();
+}
+
+static double runProgram(const std::string& program) {
+    const std::string codeFile = "bench_array_args_pcode.txt";
+    const std::string resultFile = "bench_array_args_result.txt";
+    writeFile(codeFile, program);
+    double ms;
+    {
+        SilenceCout silence;
+        PCodeInterpreter interpreter;
+        ms = timeMs([&] { interpreter.run(codeFile, resultFile); });
+    }
+    std::remove(codeFile.c_str());
+    std::remove(resultFile.c_str());
+    return ms;
+}
+
+int main() {
+    const int calls = 100000;
+    const int repeats = 3;
+    std::printf("%10s %12s %12s\n", "size", "total(ms)", "ns/call");
+    for (int size : {1000, 1000000}) {
+        double baseMs = 1e30, ms = 1e30;
+        for (int r = 0; r < repeats; r++) {
+            baseMs = std::min(baseMs, runProgram(makeProgram(size, 0)));
+            ms = std::min(ms, runProgram(makeProgram(size, calls)));
+        }
+        std::printf("%10d %12.2f %12.1f\n", size, ms, (ms - baseMs) * 1e6 / calls);
+    }
+    return 0;
+}
@@ -0,0 +1,65 @@
+#include "alloc_counter.h"
+#include "bench_util.h"
+#include "lexer.h"
+#include "parser.h"
+#include <cstdio>
+#include <sys/resource.h>
+
+/*
+ * 语法树的建立和释放：在生成的多行源程序上只做一次语法分析，
+ * 输出建树和释放整棵树的耗时、堆分配次数和进程的峰值 RSS。
+ * 峰值 RSS 是整个进程的，所以每次运行只分析一次。
+ * bench_ast [行数]，默认 100000。
+ */
+
+static std::string makeSource(size_t lines) {
+    std::string source = "const int N = 100;\nint g[100];\n";
+    size_t count = 2;
+    for (int i = 0; count < lines; i++, count += 11) {
+        std::ostringstream func;
+        func << "int func_" << i << "(int a, int b[], char c) {\n"
+             << "    int sum_total = 0;\n"
+             << "    for (i = 0; i < a; i = i + 1) {\n"
+             << "        if (b[i] % 2 == 0 && c != 'x' || i >= 42) {\n"
+             << "            sum_total = sum_total + b[i] * 3 - (a / 7);\n"
+             << "        } else {\n"
+             << "            printf(\"value %d at %d\\n\", b[i], i);\n"
+             << "        }\n"
+             << "    }\n"
+             << "    return sum_total;\n"
+             << "}\n";
+        source += func.str();
+    }
+    source += "int main() {\n    return 0;\n}\n";
+    return source;
+}
+
+static double peakRssMb() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss / 1024.0; // Linux 上单位为 KB
+}
+
+int main(int argc, char* argv[]) {
+    size_t lines = argc > 1 ? std::stoul(argv[1]) : 100000;
+    std::string source = makeSource(lines);
+    Lexer lexer("", "", "");
+    lexer.analyzeSource(source);
+    const TokenStream& tokens = lexer.getTokens();
+    double beforeMb = peakRssMb();
+
+    Parser parser(tokens, "", "");
+    resetAllocStats();
+    std::unique_ptr<decltype(parser.parse())> ast;
+    double parseMs = timeMs([&] { ast = std::make_unique<decltype(parser.parse())>(parser.parse()); });
+    AllocStats stats = allocStats;
+    double afterMb = peakRssMb();
+    double freeMs = timeMs([&] { ast.reset(); });
+
+    std::printf("source: %zu lines, %zu tokens\n", lines, tokens.size());
+    std::printf("parse:  %8.2f ms, %zu allocations, %.2f MB allocated\n",
+                parseMs, stats.count, stats.bytes / 1048576.0);
+    std::printf("free:   %8.2f ms\n", freeMs);
+    std::printf("peak RSS: %.1f MB (%.1f MB before parsing)\n", afterMb, beforeMb);
+    return 0;
+}
@@ -0,0 +1,85 @@
+#include "bench_util.h"
+#include "pcode_interpreter.h"
+#include <algorithm>
+#include <cstdio>
+
+/*
+ * 解释器分派方式对比：同一份程序分别由 bench_dispatch_switch 和
+ * bench_dispatch_threaded 运行（两者只有 PCODE_THREADED_DISPATCH 不同）。
+ */
+
+#if PCODE_THREADED_DISPATCH
+static const char* dispatchName = "threaded";
+#else
+static const char* dispatchName = "switch";
+#endif
+
+// 循环密集：二重循环累加 i*j%7
+static std::string makeLoopProgram(int n) {
+    std::ostringstream code;
+    code << "FUNC_DEF main\n"
+         << "DEF_VAR Int L0 i\n" << "DEF_VAR Int L1 j\n" << "DEF_VAR Int L2 s\n"
+         << "PUSH 0\n" << "STORE L0\n"
+         << "LABEL OUTER\n"
+         << "LOAD L0\n" << "PUSH " << n << "\n" << "LT\n" << "JUMP_IF_FALSE OUTER_END\n"
+         << "PUSH 0\n" << "STORE L1\n"
+         << "LABEL INNER\n"
+         << "LOAD L1\n" << "PUSH " << n << "\n" << "LT\n" << "JUMP_IF_FALSE INNER_END\n"
+         << "LOAD L2\n" << "LOAD L0\n" << "LOAD L1\n" << "MULT\n" << "PUSH 7\n" << "MOD\n" << "ADD\n"
+         << "STORE L2\n"
+         << "LOAD L1\n" << "PUSH 1\n" << "ADD\n" << "STORE L1\n"
+         << "JUMP INNER\n"
+         << "LABEL INNER_END\n"
+         << "LOAD L0\n" << "PUSH 1\n" << "ADD\n" << "STORE L0\n"
+         << "JUMP OUTER\n"
+         << "LABEL OUTER_END\n"
+         << "LABEL mainEND_FUNC\n" << "END_FUNC\n";
+    return code.str();
+}
+
+// 调用密集：递归 fib(n)
+static std::string makeCallProgram(int n) {
+    std::ostringstream code;
+    code << "FUNC_DEF fib\n" << "JUMP fibEND_FUNC\n"
+         << "DEF_VAR Int L0 n\n" << "LOAD_PARAM 0 L0\n" << "FUNCBLOCKNOW\n"
+         << "LOAD L0\n" << "PUSH 2\n" << "LT\n" << "JUMP_IF_FALSE ELSE\n"
+         << "LOAD L0\n" << "RETURN\n"
+         << "LABEL ELSE\n"
+         << "LOAD L0\n" << "PUSH 1\n" << "SUB\n" << "CALL fib\n"
+         << "LOAD L0\n" << "PUSH 2\n" << "SUB\n" << "CALL fib\n"
+         << "ADD\n" << "RETURN\n"
+         << "LABEL fibEND_FUNC\n" << "END_FUNC\n"
+         << "FUNC_DEF main\n"
+         << "DEF_VAR Int L0 r\n"
+         << "PUSH " << n << "\n" << "CALL fib\n" << "STORE L0\n"
+         << "LABEL mainEND_FUNC\n" << "END_FUNC\n";
+    return code.str();
+}
+
+static double runProgram(const std::string& program) {
+    const std::string codeFile = "bench_dispatch_pcode.txt";
+    const std::string resultFile = "bench_dispatch_result.txt";
+    writeFile(codeFile, program);
+    double ms;
+    {
+        SilenceCout silence;
+        PCodeInterpreter interpreter;
+        ms = timeMs([&] { interpreter.run(codeFile, resultFile); });
+    }
+    std::remove(codeFile.c_str());
+    std::remove(resultFile.c_str());
+    return ms;
+}
+
+int main() {
+    const int repeats = 3;
+    double loopMs = 1e30, callMs = 1e30;
+    for (int r = 0; r < repeats; r++) {
+        loopMs = std::min(loopMs, runProgram(makeLoopProgram(1000)));
+        callMs = std::min(callMs, runProgram(makeCallProgram(24)));
+    }
+    std::printf("dispatch: %s\n", dispatchName);
+    std::printf("loop-heavy (1000x1000 nested loop): %10.2f ms\n", loopMs);
+    std::printf("call-heavy (fib(24) recursion):     %10.2f ms\n", callMs);
+    return 0;
+}
@@ -0,0 +1,30 @@
+#include "bench_util.h"
+#include "pcode_interpreter.h"
+#include <cstdio>
+
+/*
+ * 指令内存占用：文本形式（每条指令一个 vector<string>）与定长编码的对比。
+ * 用法：bench_encoding [P_code.txt]
+ */
+
+int main(int argc, char* argv[]) {
+    std::string codeFile = argc > 1 ? argv[1] : "P_code.txt";
+    std::ifstream probe(codeFile);
+    if (!probe.is_open()) {
+        std::fprintf(stderr, "Error: Could not open %s\n", codeFile.c_str());
+        return 1;
+    }
+
+    PCodeInterpreter interpreter;
+    double ms = timeMs([&] { interpreter.load(codeFile); });
+    const InstructionMemory& memory = interpreter.instructionMemory();
+
+    std::printf("instructions:          %zu\n", memory.count);
+    std::printf("sizeof(Instruction):   %zu bytes\n", sizeof(Instruction));
+    std::printf("text form:             %zu bytes (%.1f bytes/instr)\n",
+                memory.textBytes, (double)memory.textBytes / memory.count);
+    std::printf("encoded + string pool: %zu bytes (%.1f bytes/instr)\n",
+                memory.encodedBytes, (double)memory.encodedBytes / memory.count);
+    std::printf("load time:             %.2f ms\n", ms);
+    return 0;
+}
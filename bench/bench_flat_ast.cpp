@@ -0,0 +1,145 @@
+#include "bench_util.h"
+#include "flat_ast.h"
+#include "lexer.h"
+#include "parser.h"
+#include <algorithm>
+#include <cstdio>
+
+/*
+ * 指针树与扁平语法树的遍历：在生成的多行源程序上建树并转换成 FlatAst，
+ * 输出转换耗时，以及两种表示上同样两趟遍历的耗时：
+ *   全树：按结点种类计数、累加 Number 的值、统计 LVal 个数；
+ *   语句：只看语句，跳过表达式子树（扁平树上直接跳到 subtreeEnd）。
+ * 两种表示的结果必须相同，否则退出码为 1。
+ * bench_flat_ast [行数]，默认 100000。
+ */
+
+static std::string makeSource(size_t lines) {
+    std::string source = "const int N = 100;\nint g[100];\n";
+    size_t count = 2;
+    for (int i = 0; count < lines; i++, count += 11) {
+        std::ostringstream func;
+        func << "int func_" << i << "(int a, int b[], char c) {\n"
+             << "    int sum_total = 0;\n"
+             << "    for (i = 0; i < a; i = i + 1) {\n"
+             << "        if (b[i] % 2 == 0 && c != 'x' || i >= 42) {\n"
+             << "            sum_total = sum_total + b[i] * 3 - (a / 7);\n"
+             << "        } else {\n"
+             << "            printf(\"value %d at %d\\n\", b[i], i);\n"
+             << "        }\n"
+             << "    }\n"
+             << "    return sum_total;\n"
+             << "}\n";
+        source += func.str();
+    }
+    source += "int main() {\n    return 0;\n}\n";
+    return source;
+}
+
+struct Totals {
+    size_t kinds[NODE_SmallFor + 1] = {};
+    long long numbers = 0;
+    size_t lvals = 0;
+    size_t statements = 0;
+
+    bool operator==(const Totals& other) const {
+        return std::equal(kinds, kinds + NODE_SmallFor + 1, other.kinds) && numbers == other.numbers
+               && lvals == other.lvals && statements == other.statements;
+    }
+};
+
+static bool isExpression(NodeType kind) {
+    switch (kind) {
+        case NODE_LVAL: case NODE_UNARYEXP: case NODE_FUNCRPARAMS: case NODE_MULEXP: case NODE_ADDEXP:
+        case NODE_RELEXP: case NODE_EQEXP: case NODE_LANDEXP: case NODE_LOREXP: case NODE_NUMBER:
+        case NODE_CHARACTER:
+            return true;
+        default:
+            return false;
+    }
+}
+
+static void walkTree(const ASTNode* node, Totals& totals) {
+    totals.kinds[node->type]++;
+    if (node->type == NODE_NUMBER) {
+        totals.numbers += static_cast<const NumberNode*>(node)->value;
+    } else if (node->type == NODE_LVAL) {
+        totals.lvals++;
+    }
+    visitChildren(node, [&](const ASTNode* child) {
+        if (child) {
+            walkTree(child, totals);
+        }
+    });
+}
+
+static void walkTreeStatements(const ASTNode* node, Totals& totals) {
+    totals.statements++;
+    visitChildren(node, [&](const ASTNode* child) {
+        if (child && !isExpression(child->type)) {
+            walkTreeStatements(child, totals);
+        }
+    });
+}
+
+static void walkFlat(const FlatAst& ast, Totals& totals) {
+    for (uint32_t i = 0; i < ast.size(); i++) {
+        const FlatNode& node = ast[i];
+        totals.kinds[node.kind]++;
+        if (node.kind == NODE_NUMBER) {
+            totals.numbers += node.a;
+        } else if (node.kind == NODE_LVAL) {
+            totals.lvals++;
+        }
+    }
+}
+
+static void walkFlatStatements(const FlatAst& ast, Totals& totals) {
+    for (uint32_t i = 0; i < ast.size();) {
+        const FlatNode& node = ast[i];
+        if (isExpression(node.kind)) {
+            i = node.subtreeEnd;
+        } else {
+            totals.statements++;
+            i++;
+        }
+    }
+}
+
+template <typename F>
+static double best(F&& f) {
+    double result = 1e30;
+    for (int r = 0; r < 5; r++) {
+        result = std::min(result, timeMs(f));
+    }
+    return result;
+}
+
+int main(int argc, char* argv[]) {
+    size_t lines = argc > 1 ? std::stoul(argv[1]) : 100000;
+    std::string source = makeSource(lines);
+    Lexer lexer("", "", "");
+    lexer.analyzeSource(source);
+    Parser parser(lexer.getTokens(), "", "");
+    SyntaxTree tree = parser.parse();
+
+    FlatAst flat;
+    double flattenMs = best([&] { flat = flattenAst(tree.root); });
+
+    Totals treeTotals, flatTotals;
+    double treeMs = best([&] { treeTotals = Totals(); walkTree(tree.root, treeTotals); });
+    double flatMs = best([&] { flatTotals = Totals(); walkFlat(flat, flatTotals); });
+    double treeStmtMs = best([&] { treeTotals.statements = 0; walkTreeStatements(tree.root, treeTotals); });
+    double flatStmtMs = best([&] { flatTotals.statements = 0; walkFlatStatements(flat, flatTotals); });
+
+    std::printf("source:     %zu lines, %zu nodes, %.2f MB in arena\n",
+                lines, flat.size(), tree.arena->bytesAllocated() / 1048576.0);
+    std::printf("flatten:    %8.2f ms\n", flattenMs);
+    std::printf("full walk:  tree %8.2f ms  flat %8.2f ms  (%.1fx)\n", treeMs, flatMs, treeMs / flatMs);
+    std::printf("statements: tree %8.2f ms  flat %8.2f ms  (%.1fx)\n", treeStmtMs, flatStmtMs, treeStmtMs / flatStmtMs);
+    if (!(treeTotals == flatTotals)) {
+        std::printf("MISMATCH between tree and flat traversals\n");
+        return 1;
+    }
+    return 0;
+}
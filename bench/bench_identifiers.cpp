@@ -0,0 +1,64 @@
+#include "alloc_counter.h"
+#include "bench_util.h"
+#include "interner.h"
+#include "pipeline.h"
+#include <algorithm>
+#include <cstdio>
+
+/*
+ * 标识符很多的程序上编译前端（词法、语法、语义分析和 P-code 生成）的时间和堆分配。
+ * 程序含 G 个全局变量、F 个函数，每个函数 L 个局部变量，名字都不相同且较长。
+ * bench_identifiers [G] [F] [L]，默认 4000 60 40。
+ * 时间取多次中最快的，堆分配取第一次。
+ */
+
+static std::string makeSource(int globals, int functions, int locals) {
+    std::ostringstream source;
+    for (int i = 0; i < globals; i++) {
+        source << "int global_counter_value_" << i << " = " << i % 100 << ";\n";
+    }
+    for (int f = 0; f < functions; f++) {
+        source << "int compute_function_number_" << f << "(int parameter_alpha_" << f << ") {\n";
+        for (int l = 0; l < locals; l++) {
+            int g = (f * locals + l) % globals;
+            source << "    int local_temporary_" << f << "_" << l << " = global_counter_value_" << g
+                   << " + parameter_alpha_" << f << ";\n";
+            source << "    global_counter_value_" << g << " = local_temporary_" << f << "_" << l << " * 2;\n";
+        }
+        source << "    return local_temporary_" << f << "_0;\n}\n";
+    }
+    source << "int main() {\n    int total_sum = 0;\n";
+    for (int f = 0; f < functions; f++) {
+        source << "    total_sum = total_sum + compute_function_number_" << f << "(" << f << ");\n";
+    }
+    source << "    printf(\"%d\\n\", total_sum);\n    return 0;\n}\n";
+    return source.str();
+}
+
+int main(int argc, char* argv[]) {
+    int globals = argc > 1 ? std::stoi(argv[1]) : 4000;
+    int functions = argc > 2 ? std::stoi(argv[2]) : 60;
+    int locals = argc > 3 ? std::stoi(argv[3]) : 40;
+    std::string source = makeSource(globals, functions, locals);
+
+    double best = 1e30;
+    AllocStats stats;
+    size_t codeSize = 0;
+    for (int r = 0; r < 5; r++) {
+        resetAllocStats();
+        best = std::min(best, timeMs([&] {
+            CompileResult result = compileSource(source);
+            codeSize = result.code.size();
+        }));
+        if (r == 0) {
+            stats = allocStats; //第一次编译时标识符表还是空的，计入驻留的开销
+        }
+    }
+
+    std::printf("source: %zu bytes, %d globals, %d functions x %d locals, %zu interned names\n",
+                source.size(), globals, functions, locals, identifiers.size());
+    std::printf("compile:  %8.2f ms, %zu instructions\n", best, codeSize);
+    std::printf("heap:     %zu allocations, %.2f MB allocated, peak %.2f MB\n",
+                stats.count, stats.bytes / 1048576.0, stats.peak / 1048576.0);
+    return 0;
+}
@@ -0,0 +1,60 @@
+#include "bench_util.h"
+#include "pcode_interpreter.h"
+#include <algorithm>
+#include <cstdio>
+
+/*
+ * 跳转开销与程序长度的关系：
+ * 同一个计数循环后面追加不同数量的无关指令，
+ * 标签预先解析后每轮循环的耗时不应随程序变长而增加。
+ * 程序加载一次后重复执行，加载时间单独列出，不计入循环耗时。
+ */
+
+// 生成 P-code：main 中循环 iters 次，循环之后追加 padding 条 LABEL
+static std::string makeLoopProgram(int iters, int padding) {
+    std::ostringstream code;
+    code << "FUNC_DEF main\n";
+    code << "DEF_VAR Int L0 i\n";
+    code << "PUSH 0\n";
+    code << "STORE L0\n";
+    code << "LABEL LOOP\n";
+    code << "LOAD L0\n";
+    code << "PUSH " << iters << "\n";
+    code << "LT\n";
+    code << "JUMP_IF_FALSE END\n";
+    code << "LOAD L0\n";
+    code << "PUSH 1\n";
+    code << "ADD\n";
+    code << "STORE L0\n";
+    code << "JUMP LOOP\n";
+    code << "LABEL END\n";
+    for (int k = 0; k < padding; k++) {
+        code << "LABEL PAD" << k << "\n";
+    }
+    code << "LABEL mainEND_FUNC\n";
+    code << "END_FUNC\n";
+    return code.str();
+}
+
+int main() {
+    const int iters = 5000000;
+    const int repeats = 5;
+    const int paddings[] = {0, 1000, 10000, 100000};
+    const std::string resultFile = "bench_jump_result.txt";
+
+    std::printf("%10s %12s %12s %14s\n", "padding", "load(ms)", "loop(ms)", "ns/iteration");
+    for (int padding : paddings) {
+        // 只加载一次，计时只含执行；取多次中的最小值
+        SilenceCout silence;
+        PCodeInterpreter interpreter;
+        std::string code = makeLoopProgram(iters, padding);
+        double loadMs = timeMs([&] { interpreter.loadCode(code); });
+        double loopMs = 1e300;
+        for (int r = 0; r < repeats; r++) {
+            loopMs = std::min(loopMs, timeMs([&] { interpreter.runLoaded(resultFile); }));
+        }
+        std::printf("%10d %12.2f %12.2f %14.2f\n", padding, loadMs, loopMs, loopMs * 1e6 / iters);
+    }
+    std::remove(resultFile.c_str());
+    return 0;
+}
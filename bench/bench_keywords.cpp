@@ -0,0 +1,98 @@
+#include "bench_util.h"
+#include "lexer.h"
+#include <algorithm>
+#include <cstdio>
+#include <unordered_map>
+
+/*
+ * 关键字识别：在以标识符和关键字为主的源程序上，
+ * 1. 单独比较按 string 查 unordered_map（原做法）与 keywordType 的耗时；
+ * 2. 测整个词法分析的吞吐量（MB/s）。
+ * bench_keywords [MB]，默认 8。
+ */
+
+static const char* const names[] = {
+    "i", "j", "n", "sum", "count", "index", "value", "result", "buffer_len",
+    "getint_value", "printf_count", "const_table", "int_array", "char_code",
+    "if_flag", "elseValue", "for_each", "breakpoint", "continue_at", "returned",
+    "mainLoop", "voidable", "getc", "print", "ret", "whilex", "do_it", "x1", "_tmp"
+};
+static const char* const words[] = {
+    "const", "int", "char", "void", "if", "else", "for", "break", "continue",
+    "return", "getint", "getchar", "printf"
+};
+
+/*标识符与关键字约 3:1，中间只有空格、分号和少量运算符*/
+static std::string makeSource(size_t bytes) {
+    std::string source;
+    size_t n = 0;
+    while (source.size() < bytes) {
+        for (int k = 0; k < 8; k++, n++) {
+            source += names[(n * 7) % std::size(names)];
+            source += ' ';
+            if (k % 3 == 2) {
+                source += words[(n * 5) % std::size(words)];
+                source += ' ';
+            }
+        }
+        source += (n % 3 == 0) ? "= sum_total;\n" : ";\n";
+    }
+    return source;
+}
+
+int main(int argc, char* argv[]) {
+    size_t megabytes = argc > 1 ? std::stoul(argv[1]) : 8;
+    std::string source = makeSource(megabytes << 20);
+    double mb = source.size() / double(1 << 20);
+
+    // 先做一遍词法分析，取出所有标识符和关键字用于单独比较查找
+    std::vector<std::string_view> candidates;
+    {
+        Lexer lexer("", "", "");
+        lexer.analyzeSource(source);
+        const TokenStream& tokens = lexer.getTokens();
+        for (size_t i = 0; i < tokens.size(); i++) {
+            if (tokens.type(i) == IDENFR || keywordType(tokens.value(i)) != IDENFR) {
+                candidates.push_back(tokens.value(i));
+            }
+        }
+    }
+
+    std::unordered_map<std::string, TokenType> keywordMap;
+    for (const Keyword& keyword : keywords) {
+        keywordMap.emplace(std::string(keyword.text), keyword.type);
+    }
+
+    double mapMs = 1e30, tableMs = 1e30, lexerMs = 1e30;
+    size_t mapHits = 0, tableHits = 0, tokenCount = 0;
+    for (int r = 0; r < 3; r++) {
+        mapMs = std::min(mapMs, timeMs([&] {
+            mapHits = 0;
+            for (std::string_view word : candidates) {
+                auto it = keywordMap.find(std::string(word));
+                mapHits += it != keywordMap.end();
+            }
+        }));
+        tableMs = std::min(tableMs, timeMs([&] {
+            tableHits = 0;
+            for (std::string_view word : candidates) {
+                tableHits += keywordType(word) != IDENFR;
+            }
+        }));
+        Lexer lexer("", "", "");
+        lexerMs = std::min(lexerMs, timeMs([&] { lexer.analyzeSource(source); }));
+        tokenCount = lexer.getTokens().size();
+    }
+    if (mapHits != tableHits) {
+        std::printf("mismatch: map %zu, table %zu\n", mapHits, tableHits);
+        return 1;
+    }
+
+    double million = candidates.size() / 1e6;
+    std::printf("source: %.1f MB, %zu tokens, %zu identifiers (%zu keywords)\n",
+                mb, tokenCount, candidates.size(), tableHits);
+    std::printf("unordered_map<string>: %8.2f ms %8.1f ns/word\n", mapMs, mapMs / million);
+    std::printf("keywordType:           %8.2f ms %8.1f ns/word\n", tableMs, tableMs / million);
+    std::printf("lexer:                 %8.2f ms %8.1f MB/s\n", lexerMs, mb / lexerMs * 1000);
+    return 0;
+}
@@ -0,0 +1,57 @@
+#include "bench_util.h"
+#include "lexer.h"
+#include <algorithm>
+#include <cstdio>
+
+/*
+ * 词法分析吞吐量：生成若干 MB 的源程序，分别从内存和文件做词法分析，输出 MB/s。
+ * bench_lexer [MB]，默认 8。
+ */
+
+static std::string makeSource(size_t bytes) {
+    std::string source = "const int N = 100;\nint g[100];\n";
+    for (int i = 0; source.size() < bytes; i++) {
+        std::ostringstream func;
+        func << "int func_" << i << "(int a, int b[], char c) {\n"
+             << "    int sum_total = 0;\n"
+             << "    for (i = 0; i < a; i = i + 1) {\n"
+             << "        if (b[i] % 2 == 0 && c != 'x' || i >= 42) {\n"
+             << "            sum_total = sum_total + b[i] * 3 - (a / 7);\n"
+             << "        } else {\n"
+             << "            printf(\"value %d at %d\\n\", b[i], i);\n"
+             << "        }\n"
+             << "    }\n"
+             << "    return sum_total;\n"
+             << "}\n";
+        source += func.str();
+    }
+    return source;
+}
+
+int main(int argc, char* argv[]) {
+    size_t megabytes = argc > 1 ? std::stoul(argv[1]) : 8;
+    std::string source = makeSource(megabytes << 20);
+    const std::string sourceFile = "bench_lexer_source.txt";
+    writeFile(sourceFile, source);
+    double mb = source.size() / double(1 << 20);
+
+    double memoryMs = 1e30, fileMs = 1e30;
+    size_t tokenCount = 0;
+    for (int r = 0; r < 3; r++) {
+        {
+            Lexer lexer("", "", "");
+            memoryMs = std::min(memoryMs, timeMs([&] { lexer.analyzeSource(source); }));
+            tokenCount = lexer.getTokens().size();
+        }
+        {
+            Lexer lexer(sourceFile, "", "");
+            fileMs = std::min(fileMs, timeMs([&] { lexer.analyze(); }));
+        }
+    }
+    std::remove(sourceFile.c_str());
+
+    std::printf("source: %.1f MB, %zu tokens\n", mb, tokenCount);
+    std::printf("in memory: %8.2f ms %8.1f MB/s\n", memoryMs, mb / memoryMs * 1000);
+    std::printf("from file: %8.2f ms %8.1f MB/s\n", fileMs, mb / fileMs * 1000);
+    return 0;
+}
@@ -0,0 +1,66 @@
+#include "bench_util.h"
+#include "lexer.h"
+#include <algorithm>
+#include <cstdio>
+
+/*
+ * 词法分析各扫描实现（标量、SSE2、AVX2）的吞吐量对比。
+ * 输入以标识符和空白为主，分两种：
+ *   short：短标识符、4 空格缩进，接近一般的源程序；
+ *   long：长标识符、深缩进和空行，SIMD 一次能跳过更多字节。
+ * bench_lexer_simd [MB]，默认 8。
+ */
+
+static std::string makeSource(size_t bytes, bool wide) {
+    static const char* const shortNames[] = {"i", "n", "sum", "idx", "val", "tmp", "cnt", "a1"};
+    static const char* const longNames[] = {
+        "accumulated_partial_sum", "current_row_index_value", "temporaryBufferLength",
+        "number_of_remaining_items", "previous_iteration_result", "maximumAllowedDepth"
+    };
+    std::string source;
+    for (size_t n = 0; source.size() < bytes; n++) {
+        int depth = wide ? 4 + n % 12 : 1 + n % 3;
+        source.append(depth * 4, ' ');
+        for (int k = 0; k < 5; k++) {
+            source += wide ? longNames[(n + k) % std::size(longNames)] : shortNames[(n * 3 + k) % std::size(shortNames)];
+            source += k % 2 ? " = " : " + ";
+        }
+        source += std::to_string(n % 100000);
+        source += ";\n";
+        if (wide && n % 4 == 0) {
+            source += "\n\t\t\n";
+        }
+    }
+    return source;
+}
+
+static void run(const char* label, const std::string& source) {
+    double mb = source.size() / double(1 << 20);
+    double scalarMs = 0;
+    for (LexerBackend backend : {LEXER_SCALAR, LEXER_SSE2, LEXER_AVX2}) {
+        if (!lexerBackendSupported(backend)) {
+            continue;
+        }
+        double best = 1e30;
+        size_t tokenCount = 0;
+        for (int r = 0; r < 3; r++) {
+            Lexer lexer("", "", "");
+            lexer.setBackend(backend);
+            best = std::min(best, timeMs([&] { lexer.analyzeSource(source); }));
+            tokenCount = lexer.getTokens().size();
+        }
+        if (backend == LEXER_SCALAR) {
+            scalarMs = best;
+        }
+        std::printf("%-5s %-6s %.1f MB %9zu tokens %8.2f ms %8.1f MB/s  x%.2f\n", label,
+                    scanKernels(backend).name, mb, tokenCount, best, mb / best * 1000, scalarMs / best);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    size_t megabytes = argc > 1 ? std::stoul(argv[1]) : 8;
+    std::printf("auto selects %s\n", scanKernels().name);
+    run("short", makeSource(megabytes << 20, false));
+    run("long", makeSource(megabytes << 20, true));
+    return 0;
+}
@@ -0,0 +1,58 @@
+#include "alloc_counter.h"
+#include "bench_util.h"
+#include "lexer.h"
+#include "parser.h"
+#include <algorithm>
+#include <cstdio>
+
+/*
+ * 语法分析的每单词开销：先做词法分析，只对 Parser::parse 计时并统计堆分配，
+ * 输出每个单词的分配次数和耗时。取单词本身不分配，结点从 arena 按块分配。
+ * bench_parser [MB]，默认 4。
+ */
+
+static std::string makeSource(size_t bytes) {
+    std::string source = "const int N = 100;\nint g[100];\n";
+    for (int i = 0; source.size() < bytes; i++) {
+        std::ostringstream func;
+        func << "int func_" << i << "(int a, int b[], char c) {\n"
+             << "    int sum_total = 0;\n"
+             << "    for (i = 0; i < a; i = i + 1) {\n"
+             << "        if (b[i] % 2 == 0 && c != 'x' || i >= 42) {\n"
+             << "            sum_total = sum_total + b[i] * 3 - (a / 7);\n"
+             << "        } else {\n"
+             << "            printf(\"value %d at %d\\n\", b[i], i);\n"
+             << "        }\n"
+             << "    }\n"
+             << "    return sum_total;\n"
+             << "}\n";
+        source += func.str();
+    }
+    source += "int main() {\n    return 0;\n}\n";
+    return source;
+}
+
+int main(int argc, char* argv[]) {
+    size_t megabytes = argc > 1 ? std::stoul(argv[1]) : 4;
+    std::string source = makeSource(megabytes << 20);
+    Lexer lexer("", "", "");
+    lexer.analyzeSource(source);
+    const TokenStream& tokens = lexer.getTokens();
+
+    double best = 1e30;
+    AllocStats stats;
+    for (int r = 0; r < 3; r++) {
+        Parser parser(tokens, "", "");
+        SyntaxTree ast;
+        resetAllocStats();
+        best = std::min(best, timeMs([&] { ast = parser.parse(); }));
+        stats = allocStats;
+    }
+
+    double count = tokens.size();
+    std::printf("tokens: %zu\n", tokens.size());
+    std::printf("parse:  %8.2f ms %8.1f ns/token\n", best, best * 1e6 / count);
+    std::printf("heap:   %zu allocations, %.3f per token, %.1f bytes per token\n",
+                stats.count, stats.count / count, stats.bytes / count);
+    return 0;
+}
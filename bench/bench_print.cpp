@@ -0,0 +1,43 @@
+#include "bench_util.h"
+#include "pcode_interpreter.h"
+#include <algorithm>
+#include <cstdio>
+
+/*
+ * 输出密集：循环 n 次 printf("i=%d, c=%c, sum=%d\n", ...)。
+ * 格式串在加载时拆成段，执行时只做拼接和整数转换。
+ */
+
+static std::string makeProgram(int n) {
+    std::ostringstream code;
+    code << "FUNC_DEF main\n"
+         << "DEF_VAR Int L0 i\n" << "DEF_VAR Int L1 s\n"
+         << "PUSH 0\n" << "STORE L0\n"
+         << "LABEL LOOP\n"
+         << "LOAD L0\n" << "PUSH " << n << "\n" << "LT\n" << "JUMP_IF_FALSE LOOP_END\n"
+         << "LOAD L1\n" << "LOAD L0\n" << "ADD\n" << "STORE L1\n"
+         << "LOAD L0\n" << "PUSH 65\n" << "LOAD L1\n"
+         << "PRINT \"i=%d, c=%c, sum=%d\\n\"\n"
+         << "LOAD L0\n" << "PUSH 1\n" << "ADD\n" << "STORE L0\n"
+         << "JUMP LOOP\n"
+         << "LABEL LOOP_END\n"
+         << "LABEL mainEND_FUNC\n" << "END_FUNC\n";
+    return code.str();
+}
+
+int main() {
+    const int n = 1000000;
+    const std::string codeFile = "bench_print_pcode.txt";
+    const std::string resultFile = "bench_print_result.txt";
+    writeFile(codeFile, makeProgram(n));
+    double ms = 1e30;
+    for (int r = 0; r < 3; r++) {
+        SilenceCout silence;
+        PCodeInterpreter interpreter;
+        ms = std::min(ms, timeMs([&] { interpreter.run(codeFile, resultFile); }));
+    }
+    std::remove(codeFile.c_str());
+    std::remove(resultFile.c_str());
+    std::printf("%d prints: %.2f ms (%.1f ns/print)\n", n, ms, ms * 1e6 / n);
+    return 0;
+}
@@ -0,0 +1,59 @@
+#include "bench_util.h"
+#include "lexer.h"
+#include "parser.h"
+#include "semantic_analyzer.h"
+#include <algorithm>
+#include <cstdio>
+
+/*
+ * 符号表查找：G 个全局变量，main 里嵌套 D 层语句块，每层定义一个遮住外层的同名变量和一个本层变量，
+ * 最内层有 R 条语句，每条引用若干全局变量和各层的局部变量。
+ * 只对语义分析计时，词法、语法分析和代码生成在计时之外。
+ * bench_symbols [G] [D] [R]，默认 4000 100 4000。
+ */
+
+static std::string makeSource(int globals, int depth, int statements) {
+    std::ostringstream source;
+    for (int i = 0; i < globals; i++) {
+        source << "int global_symbol_" << i << " = " << i % 100 << ";\n";
+    }
+    source << "int main() {\n";
+    for (int d = 0; d < depth; d++) {
+        source << "{\n    int shadowed = " << d << ";\n    int level_" << d << " = shadowed;\n";
+    }
+    for (int s = 0; s < statements; s++) {
+        int g = (s * 7919) % globals;
+        int d = s % depth;
+        source << "    global_symbol_" << g << " = global_symbol_" << (g + 1) % globals
+               << " + level_" << d << " * shadowed - level_0;\n";
+    }
+    for (int d = 0; d < depth; d++) {
+        source << "}\n";
+    }
+    source << "    return 0;\n}\n";
+    return source.str();
+}
+
+int main(int argc, char* argv[]) {
+    int globals = argc > 1 ? std::stoi(argv[1]) : 4000;
+    int depth = argc > 2 ? std::stoi(argv[2]) : 100;
+    int statements = argc > 3 ? std::stoi(argv[3]) : 4000;
+    std::string source = makeSource(globals, depth, statements);
+    Lexer lexer("", "", "");
+    lexer.analyzeSource(source);
+
+    double best = 1e30;
+    size_t errors = 0;
+    for (int r = 0; r < 5; r++) {
+        Parser parser(lexer.getTokens(), "", "");
+        SyntaxTree ast = parser.parse();
+        SemanticAnalyzer analyzer(ast);
+        best = std::min(best, timeMs([&] { analyzer.analyze(); }));
+        errors = analyzer.getErrorLines().size();
+    }
+
+    std::printf("source:   %d globals, depth %d, %d statements\n", globals, depth, statements);
+    std::printf("analyze:  %8.2f ms, %.1f ns per statement, %zu errors\n",
+                best, best * 1e6 / statements, errors);
+    return errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,44 @@
+#ifndef BENCH_UTIL_H
+#define BENCH_UTIL_H
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+/*基准测试公用工具*/
+
+// 丢弃所有写入的流缓冲
+class NullBuffer : public std::streambuf {
+protected:
+    int overflow(int c) override { return c; }
+    std::streamsize xsputn(const char*, std::streamsize n) override { return n; }
+};
+
+// 作用域内把 cout 重定向到空流，屏蔽解释器的调试输出
+class SilenceCout {
+public:
+    SilenceCout() : old(std::cout.rdbuf(&sink)) {}
+    ~SilenceCout() { std::cout.rdbuf(old); }
+
+private:
+    NullBuffer sink;
+    std::streambuf* old;
+};
+
+// 计时，返回毫秒
+template <typename F>
+double timeMs(F&& f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+inline void writeFile(const std::string& filename, const std::string& content) {
+    std::ofstream out(filename);
+    out << content;
+}
+
+#endif // BENCH_UTIL_H
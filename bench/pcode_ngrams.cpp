@@ -0,0 +1,85 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+/*
+ * 统计 P-code 语料中操作码 n-gram 的出现次数，用来挑选值得融合的超级指令。
+ * 用法：pcode_ngrams [--max-n N] [--top K] P_code.txt...
+ * 统计不跨越 LABEL / FUNC_DEF：跳转目标处的序列无法融合。
+ */
+
+int main(int argc, char* argv[]) {
+    int maxN = 4;
+    int top = 20;
+    std::vector<std::string> files;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--max-n" && i + 1 < argc) {
+            maxN = std::atoi(argv[++i]);
+        } else if (arg == "--top" && i + 1 < argc) {
+            top = std::atoi(argv[++i]);
+        } else {
+            files.push_back(arg);
+        }
+    }
+    if (files.empty()) {
+        std::fprintf(stderr, "usage: %s [--max-n N] [--top K] P_code.txt...\n", argv[0]);
+        return 1;
+    }
+
+    std::map<std::string, long> counts[16];
+    maxN = std::min(std::max(maxN, 2), 15);
+    long total = 0;
+    for (const auto& file : files) {
+        std::ifstream input(file);
+        if (!input.is_open()) {
+            std::fprintf(stderr, "Error: Could not open %s\n", file.c_str());
+            continue;
+        }
+        std::vector<std::string> window;
+        std::string line;
+        while (std::getline(input, line)) {
+            std::string opcode = line.substr(0, line.find(' '));
+            if (opcode.empty()) {
+                continue;
+            }
+            total++;
+            if (opcode == "LABEL" || opcode == "FUNC_DEF") {
+                window.clear();
+                continue;
+            }
+            window.push_back(opcode);
+            if (window.size() > (size_t)maxN) {
+                window.erase(window.begin());
+            }
+            // 以当前指令结尾的每个 n-gram
+            for (int n = 2; n <= (int)window.size(); n++) {
+                std::string gram;
+                for (size_t k = window.size() - n; k < window.size(); k++) {
+                    gram += (gram.empty() ? "" : " / ") + window[k];
+                }
+                counts[n][gram]++;
+            }
+        }
+    }
+
+    std::printf("%ld instructions in %zu file(s)\n", total, files.size());
+    for (int n = 2; n <= maxN; n++) {
+        std::vector<std::pair<long, std::string>> sorted;
+        for (const auto& entry : counts[n]) {
+            sorted.push_back({entry.second, entry.first});
+        }
+        std::sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) {
+            return a.first != b.first ? a.first > b.first : a.second < b.second;
+        });
+        std::printf("\n%d-grams:\n", n);
+        for (int i = 0; i < top && i < (int)sorted.size(); i++) {
+            std::printf("%8ld  %s\n", sorted[i].first, sorted[i].second.c_str());
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,82 @@
+#include "pipeline.h"
+#include "peephole.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/*
+ * 统计源程序语料编译出的 P-code 条数：不做优化、常量折叠（CompileOptions::foldConstants）之后、
+ * 再做窥孔优化（peepholeOptimize）之后，输出每个文件的条数和合计，以及窥孔优化每条规则删掉的条数。
+ * 用法：pcode_size testfile.txt...
+ */
+
+static std::vector<PCodeLine> compile(const std::string& source, bool fold) {
+    CompileOptions options;
+    options.foldConstants = fold;
+    options.peephole = false;
+    return compileSource(source, options).code;
+}
+
+static void add(PeepholeStats& total, const PeepholeStats& stats) {
+    total.zheng += stats.zheng;
+    total.negatedPush += stats.negatedPush;
+    total.constBranches += stats.constBranches;
+    total.jumpToNext += stats.jumpToNext;
+    total.threadedJumps += stats.threadedJumps;
+    total.unreachable += stats.unreachable;
+    total.storeLoad += stats.storeLoad;
+    total.unusedLabels += stats.unusedLabels;
+    total.passes = std::max(total.passes, stats.passes);
+}
+
+static double percent(size_t part, size_t whole) {
+    return whole ? 100.0 * part / whole : 0.0;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: %s testfile.txt...\n", argv[0]);
+        return 1;
+    }
+
+    size_t totalPlain = 0;
+    size_t totalFolded = 0;
+    size_t totalOptimized = 0;
+    PeepholeStats rules;
+    std::printf("%10s %10s %10s  %s\n", "plain", "folded", "peephole", "file");
+    for (int i = 1; i < argc; i++) {
+        std::ifstream input(argv[i]);
+        if (!input.is_open()) {
+            std::fprintf(stderr, "Error: Could not open %s\n", argv[i]);
+            continue;
+        }
+        std::stringstream buffer;
+        buffer << input.rdbuf();
+        std::string source = buffer.str();
+
+        size_t plain = compile(source, false).size();
+        std::vector<PCodeLine> code = compile(source, true);
+        size_t folded = code.size();
+        add(rules, peepholeOptimize(code));
+        totalPlain += plain;
+        totalFolded += folded;
+        totalOptimized += code.size();
+        std::printf("%10zu %10zu %10zu  %s\n", plain, folded, code.size(), argv[i]);
+    }
+    std::printf("%10zu %10zu %10zu  total\n", totalPlain, totalFolded, totalOptimized);
+    std::printf("\nconstant folding: %zu removed (%.1f%%)\n", totalPlain - totalFolded, percent(totalPlain - totalFolded, totalPlain));
+    std::printf("peephole:         %zu removed (%.1f%%), at most %zu passes\n",
+                rules.removed(), percent(rules.removed(), totalFolded), rules.passes);
+    std::printf("  ZHENG               %8zu\n", rules.zheng);
+    std::printf("  PUSH a / FU         %8zu\n", rules.negatedPush);
+    std::printf("  constant branches   %8zu\n", rules.constBranches);
+    std::printf("  jumps to next       %8zu\n", rules.jumpToNext);
+    std::printf("  unreachable         %8zu\n", rules.unreachable);
+    std::printf("  STORE x / LOAD x    %8zu\n", rules.storeLoad);
+    std::printf("  unused labels       %8zu\n", rules.unusedLabels);
+    std::printf("  (jumps threaded     %8zu)\n", rules.threadedJumps);
+    return 0;
+}
@@ -0,0 +1,504 @@
+#include "codegen.h"
+#include "const_fold.h"
+#include <iostream>
+#include <unordered_map>
+
+vector<PCodeLine> CodeGenerator::generate(const ASTNode* root) {
+    code.clear();
+    gen(root);
+    return move(code);
+}
+
+void CodeGenerator::gen(const ASTNode* node) {
+    if (!node || genFolded(node)) {
+        return;
+    }
+    switch (node->type) {
+        case NODE_COMPUNIT: {
+            auto compUnit = static_cast<const CompUnitNode*>(node);
+            for (auto& decl : compUnit->decls) {
+                gen(decl);
+            }
+            for (auto& funcDef : compUnit->funcDefs) {
+                gen(funcDef);
+            }
+            gen(compUnit->mainFuncDef);
+            break;
+        }
+        case NODE_CONSTDECL:
+            for (auto& constDef : static_cast<const ConstDeclNode*>(node)->constDefs) {
+                gen(constDef);
+            }
+            break;
+        case NODE_VARDECL:
+            for (auto& varDef : static_cast<const VarDeclNode*>(node)->varDefs) {
+                gen(varDef);
+            }
+            break;
+        case NODE_CONSTDEF:
+            genConstDef(static_cast<const ConstDefNode*>(node));
+            break;
+        case NODE_VARDEF:
+            genVarDef(static_cast<const VarDefNode*>(node));
+            break;
+        case NODE_FUNCDEF:
+            genFuncDef(static_cast<const FuncDefNode*>(node));
+            break;
+        case NODE_MAINFUNCDEF:
+            genMainFuncDef(static_cast<const MainFuncDefNode*>(node));
+            break;
+        case NODE_BLOCK:
+            genBlock(static_cast<const BlockNode*>(node));
+            break;
+        case NODE_LVAL:
+            genLVal(static_cast<const LValNode*>(node));
+            break;
+        case NODE_UNARYEXP:
+            genUnaryExp(static_cast<const UnaryExpNode*>(node));
+            break;
+        case NODE_FUNCRPARAMS:
+            genFuncRParams(static_cast<const FuncRParamsNode*>(node));
+            break;
+        case NODE_MULEXP: {
+            auto exp = static_cast<const MulExpNode*>(node);
+            genBinary(exp->operands, exp->operators);
+            break;
+        }
+        case NODE_ADDEXP: {
+            auto exp = static_cast<const AddExpNode*>(node);
+            genBinary(exp->operands, exp->operators);
+            break;
+        }
+        case NODE_RELEXP: {
+            auto exp = static_cast<const RelExpNode*>(node);
+            genBinary(exp->operands, exp->operators);
+            break;
+        }
+        case NODE_EQEXP: {
+            auto exp = static_cast<const EqExpNode*>(node);
+            genBinary(exp->operands, exp->operators);
+            break;
+        }
+        case NODE_LANDEXP:
+            genShortCircuit(static_cast<const LandExpNode*>(node)->operands, AnD, JUMP_IF_FALSE_SHORT);
+            break;
+        case NODE_LOREXP:
+            genShortCircuit(static_cast<const LorExpNode*>(node)->operands, O_R, JUMP_IF_TRUE_SHORT);
+            break;
+        case NODE_FOR:
+            genFor(static_cast<const ForNode*>(node));
+            break;
+        case NODE_RETURNSTMT:
+            genReturnStmt(static_cast<const ReturnStmtNode*>(node));
+            break;
+        case NODE_BREAKSTMT:
+            jump(JUMP, "BREAK", break_continu);
+            break;
+        case NODE_CONTINUESTMT:
+            jump(JUMP, "CONTINUE", break_continu);
+            break;
+        case NODE_PRINTFSTMT:
+            genPrintfStmt(static_cast<const PrintfStmtNode*>(node));
+            break;
+        case NODE_ASSIGNSTMT:
+            genAssignStmt(static_cast<const AssignStmtNode*>(node));
+            break;
+        case NODE_EXPSTMT:
+            gen(static_cast<const ExpStmtNode*>(node)->exp);
+            break;
+        case NODE_IFSTMT:
+            genIfStmt(static_cast<const IfStmtNode*>(node));
+            break;
+        default:
+            break; // 其余结点不生成代码
+    }
+}
+
+/*折叠成常数的表达式（包括 Number、Character）只压一个常数*/
+bool CodeGenerator::genFolded(const ASTNode* node) {
+    int value;
+    if (!isFoldedConstant(node, value)) {
+        return false;
+    }
+    emit(PUSH, {to_string(value)});
+    return true;
+}
+
+void CodeGenerator::genConstDef(const ConstDefNode* node) {
+    string slot = slotRef(node->ref);
+    emit(DEF_VAR, {string(node->constdeftype), slot, string(identifiers.name(node->name))});
+    if (node->arraysize) {
+        gen(node->arraysize);
+        emit(STORE_arraysize, {slot});
+        for (size_t i = 0; i < node->initVals.size(); ++i) {
+            gen(node->initVals[i]);
+            emit(STORE_arrayelement, {slot, to_string(i)});
+        }
+    } else {
+        gen(node->initVals[0]);
+        emit(STORE, {slot});
+    }
+}
+
+void CodeGenerator::genVarDef(const VarDefNode* node) {
+    string slot = slotRef(node->ref);
+    emit(DEF_VAR, {string(node->vardeftype), slot, string(identifiers.name(node->name))});
+    if (node->arraysize) {
+        gen(node->arraysize);
+        emit(STORE_arraysize, {slot});
+        for (size_t i = 0; i < node->initVals.size(); ++i) {
+            gen(node->initVals[i]);
+            emit(STORE_arrayelement, {slot, to_string(i)});
+        }
+    } else {
+        for (auto& initVal : node->initVals) {
+            gen(initVal);
+            emit(STORE, {slot});
+        }
+    }
+}
+
+void CodeGenerator::genFuncDef(const FuncDefNode* node) {
+    string name(identifiers.name(node->name));
+    emit(FUNC_DEF, {name});
+    emit(JUMP, {name + "END_FUNC"});
+    if (node->params) {
+        genFuncFParams(static_cast<const FuncFParamsNode*>(node->params));
+    }
+    emit(FUNCBLOCKNOW); /*进入func的block，记录numstack数量用于无效元素退栈*/
+    gen(node->block); //形参和局部变量随函数帧一起释放
+    emit(LABEL, {name + "END_FUNC"});
+    emit(END_FUNC);
+}
+
+/*实参按顺序压栈，标量和数组形参分别从栈顶往下数取到自己的实参*/
+void CodeGenerator::genFuncFParams(const FuncFParamsNode* node) {
+    int arrvarnumorder = 0;
+    int varnumorder = 0;
+    for (auto& param : node->params) {
+        if (static_cast<const FuncFParamNode*>(param)->realtype.find("Array") != string::npos) {
+            arrvarnumorder++;
+        } else {
+            varnumorder++;
+        }
+    }
+    int tmparr = 0;
+    int tmpvar = 0;
+    for (auto& param : node->params) {
+        auto paramnode = static_cast<const FuncFParamNode*>(param);
+        string slot = slotRef(paramnode->ref);
+        emit(DEF_VAR, {string(paramnode->realtype), slot, string(identifiers.name(paramnode->name))});
+        if (paramnode->realtype.find("Array") != string::npos) {
+            emit(CFarraySize, {slot});
+            emit(LOAD_ARRPARAM, {to_string(arrvarnumorder - 1 - tmparr), slot});
+            tmparr++;
+        } else {
+            emit(LOAD_PARAM, {to_string(varnumorder - 1 - tmpvar), slot});
+            tmpvar++;
+        }
+    }
+}
+
+void CodeGenerator::genMainFuncDef(const MainFuncDefNode* node) {
+    emit(FUNC_DEF, {"main"});
+    gen(node->block);
+    emit(LABEL, {"mainEND_FUNC"});
+    emit(END_FUNC);
+}
+
+void CodeGenerator::genBlock(const BlockNode* node) {
+    for (auto& stmt : node->stmts) {
+        gen(stmt);
+    }
+    for (SlotRef ref : node->popVars) {
+        emit(POP_VAR, {slotRef(ref)});
+    }
+}
+
+/*islight 为真时是赋值的左边，写入变量；否则读出*/
+void CodeGenerator::genLVal(const LValNode* node, bool islight) {
+    bool resolved = node->ref.slot >= 0;
+    if (node->indice) {
+        gen(node->indice); //类似于a[0]的[0]
+        if (resolved) {
+            emit(STORE_arrayindex);
+            if (islight) {
+                emit(STORE_arrayelement, {slotRef(node->ref), "-1"}); //-1代表去取index
+            } else {
+                emit(LOAD_arrayelement, {slotRef(node->ref), "-1"});
+            }
+        }
+    } else if (resolved) {
+        emit(islight ? STORE : LOAD, {slotRef(node->ref)});
+    }
+}
+
+void CodeGenerator::genUnaryExp(const UnaryExpNode* node) {
+    gen(node->unaryexp);
+    switch (node->unaryop) {
+        case PLUS:
+            emit(ZHENG);
+            break;
+        case MINU:
+            emit(FU);
+            break;
+        case NOT:
+            emit(FEI);
+            break;
+        default:
+            break;
+    }
+}
+
+void CodeGenerator::genFuncRParams(const FuncRParamsNode* node) {
+    for (auto& param : node->params) {
+        gen(param);
+    }
+    emit(CALL, {string(identifiers.name(node->name))});
+}
+
+/*左结合：依次求操作数，从第二个起每求完一个做一次运算*/
+void CodeGenerator::genBinary(const AstList<ASTNode*>& operands, const AstList<TokenType>& operators) {
+    for (size_t i = 0; i < operands.size(); i++) {
+        gen(operands[i]);
+        if (i == 0) {
+            continue;
+        }
+        switch (operators[i - 1]) {
+            case MULT: emit(MUL); break;
+            case DIV: emit(DiV); break;
+            case MOD: emit(MoD); break;
+            case PLUS: emit(ADD); break;
+            case MINU: emit(SUB); break;
+            case LSS: emit(LT); break;
+            case GRE: emit(GT); break;
+            case LEQ: emit(LE); break;
+            case GEQ: emit(GE); break;
+            case EQL: emit(EQ); break;
+            case NEQ: emit(NE); break;
+            default: break;
+        }
+    }
+}
+
+/*短路求值：每个操作数求完后按结果跳到表达式末尾的 shortval 标号*/
+void CodeGenerator::genShortCircuit(const AstList<ASTNode*>& operands, Opcode combine, Opcode shortJump) {
+    int tmp = 0;
+    if (operands.size() >= 2) {
+        tmp = ++shortvalorder;
+    }
+    for (size_t i = 0; i < operands.size(); ++i) {
+        gen(operands[i]);
+        if (i > 0) {
+            emit(combine);
+        }
+        if (operands.size() >= 2) {
+            jump(shortJump, "shortval", tmp);
+        }
+    }
+    if (operands.size() >= 2) {
+        label("shortval", tmp);
+    }
+}
+
+void CodeGenerator::genFor(const ForNode* node) {
+    labelfor_bk_ctn++;
+    int tmp = labelfor_bk_ctn;
+    break_continu = tmp;
+    if (node->init) {
+        genSmallfor(static_cast<const SmallforstmtNode*>(node->init));
+    }
+    label("FOR_START", tmp);
+    if (node->forcond) {
+        if (!genFolded(node->forcond)) {
+            genShortCircuit(static_cast<const LorExpNode*>(node->forcond)->operands, O_R, JUMP_IF_TRUE_SHORT);
+        }
+        jump(JUMP_IF_FALSE, "FOR_END", tmp);
+    }
+    gen(node->body);
+    label("CONTINUE", tmp);
+    if (node->step) {
+        genSmallfor(static_cast<const SmallforstmtNode*>(node->step));
+    }
+    jump(JUMP, "FOR_START", tmp);
+    label("BREAK", tmp);
+    label("FOR_END", tmp);
+    break_continu--;
+}
+
+/*先右后左*/
+void CodeGenerator::genSmallfor(const SmallforstmtNode* node) {
+    if (node->exp && !genFolded(node->exp)) {
+        auto exp = static_cast<const AddExpNode*>(node->exp);
+        genBinary(exp->operands, exp->operators);
+    }
+    if (node->lval) {
+        genLVal(static_cast<const LValNode*>(node->lval), true);
+    }
+}
+
+/*函数帧在RETURN时整体弹出，不需要逐个POP_VAR*/
+void CodeGenerator::genReturnStmt(const ReturnStmtNode* node) {
+    if (node->exp) {
+        gen(node->exp);
+        emit(RETURN);
+    } else {
+        emit(RETURN_NuLL);
+    }
+}
+
+/*格式串去掉引号存放，写成文本时再加上*/
+void CodeGenerator::genPrintfStmt(const PrintfStmtNode* node) {
+    for (auto& arg : node->args) {
+        gen(arg);
+    }
+    string_view format = node->format;
+    size_t first = format.find('"');
+    if (first != string_view::npos) {
+        size_t second = format.find('"', first + 1);
+        format = format.substr(first + 1, second == string_view::npos ? string_view::npos : second - first - 1);
+    }
+    emit(PRINT, {string(format)});
+}
+
+void CodeGenerator::genAssignStmt(const AssignStmtNode* node) {
+    if (node->exp) {
+        gen(node->exp);
+    } else if (node->getint) {
+        emit(GETINT);
+    } else if (node->getchar) {
+        emit(GETCHAR);
+    }
+    if (node->lval) {
+        genLVal(static_cast<const LValNode*>(node->lval), true);
+    }
+}
+
+void CodeGenerator::genIfStmt(const IfStmtNode* node) {
+    if_order++;
+    int cur_if = if_order;
+    if (!genFolded(node->ifcond)) {
+        genShortCircuit(static_cast<const LorExpNode*>(node->ifcond)->operands, O_R, JUMP_IF_TRUE_SHORT);
+    }
+    if (node->elseStmt) {
+        jump(JUMP_IF_FALSE, "ELSE", cur_if);
+        gen(node->thenStmt);
+        jump(JUMP, "END_IF", cur_if);
+        label("ELSE", cur_if);
+        gen(node->elseStmt);
+    } else {
+        jump(JUMP_IF_FALSE, "END_IF", cur_if);
+        gen(node->thenStmt);
+    }
+    label("END_IF", cur_if);
+}
+
+int getCharConstAscii(string_view charConst) {
+    // 检查字符常量的长度是否为 1, 2, 3 或 4
+    if (charConst.length() != 1 && charConst.length() != 2 && charConst.length() != 3 && charConst.length() != 4) {
+        cerr << "Invalid CharConst: " << charConst << ". Expected format: 'c', '\\x', 'c', or '\\x'." << endl;
+        return -1; // 返回 -1 表示错误
+    }
+
+    // 如果是长度为 1 的字符串（不带单引号）
+    if (charConst.length() == 1) {
+        char c = charConst[0];
+        // 检查字符是否在 32-126 范围内
+        if ((c >= 32 && c <= 126) || c == 10) {
+            return static_cast<int>(c); // 返回字符的 ASCII 码
+        } else {
+            cerr << "Invalid CharConst: " << charConst << ". Character must be in range 32-126." << endl;
+            return -1;
+        }
+    }
+
+    // 如果是长度为 2 的字符串（转义字符，不带单引号）
+    if (charConst.length() == 2) {
+        // 检查是否以反斜杠开头
+        if (charConst[0] != '\\') {
+            cerr << "Invalid CharConst: " << charConst << ". Escape sequence must start with '\\'." << endl;
+            return -1;
+        }
+
+        // 转义字符映射表
+        unordered_map<char, int> escapeMap = {
+            {'a', 7},   // 响铃
+            {'b', 8},   // 退格
+            {'t', 9},   // 制表符
+            {'n', 10},  // 换行
+            {'v', 11},  // 垂直制表符
+            {'f', 12},  // 换页
+            {'r', 13},  // 回车
+            {'\\', 92}, // 反斜杠
+            {'\'', 39}, // 单引号
+            {'\"', 34}, // 双引号
+            {'0', 0}    // 空字符
+        };
+
+        char escapeChar = charConst[1];
+        if (escapeMap.find(escapeChar) != escapeMap.end()) {
+            return escapeMap[escapeChar]; // 返回转义字符的 ASCII 码
+        } else {
+            cerr << "Invalid escape sequence: " << charConst << ". Unknown escape character: " << escapeChar << endl;
+            return -1;
+        }
+    }
+
+    // 如果是普通字符（长度为 3）
+    if (charConst.length() == 3) {
+        // 检查字符常量是否以单引号开头和结尾
+        if (charConst[0] != '\'' || charConst[2] != '\'') {
+            cerr << "Invalid CharConst: " << charConst << ". Must start and end with single quotes." << endl;
+            return -1;
+        }
+
+        char c = charConst[1];
+        // 检查字符是否在 32-126 范围内
+        if (c >= 32 && c <= 126) {
+            return static_cast<int>(c); // 返回字符的 ASCII 码
+        } else {
+            cerr << "Invalid CharConst: " << charConst << ". Character must be in range 32-126." << endl;
+            return -1;
+        }
+    }
+
+    // 如果是转义字符（长度为 4）
+    if (charConst.length() == 4) {
+        // 检查字符常量是否以单引号开头和结尾
+        if (charConst[0] != '\'' || charConst[3] != '\'') {
+            cerr << "Invalid CharConst: " << charConst << ". Must start and end with single quotes." << endl;
+            return -1;
+        }
+
+        // 检查是否以反斜杠开头
+        if (charConst[1] != '\\') {
+            cerr << "Invalid CharConst: " << charConst << ". Escape sequence must start with '\\'." << endl;
+            return -1;
+        }
+
+        // 转义字符映射表
+        unordered_map<char, int> escapeMap = {
+            {'a', 7},   // 响铃
+            {'b', 8},   // 退格
+            {'t', 9},   // 制表符
+            {'n', 10},  // 换行
+            {'v', 11},  // 垂直制表符
+            {'f', 12},  // 换页
+            {'r', 13},  // 回车
+            {'\\', 92}, // 反斜杠
+            {'\'', 39}, // 单引号
+            {'\"', 34}, // 双引号
+            {'0', 0}    // 空字符
+        };
+
+        char escapeChar = charConst[2];
+        if (escapeMap.find(escapeChar) != escapeMap.end()) {
+            return escapeMap[escapeChar]; // 返回转义字符的 ASCII 码
+        } else {
+            cerr << "Invalid escape sequence: " << charConst << ". Unknown escape character: " << escapeChar << endl;
+            return -1;
+        }
+    }
+
+    return -1; // 默认返回错误
+}
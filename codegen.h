@@ -0,0 +1,66 @@
+#ifndef CODEGEN_H
+#define CODEGEN_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include "ast.h"
+#include "pcode.h"
+
+using namespace std;
+
+/*
+ * 代码生成：遍历语义分析标注过的语法树，得到内存中的指令表，优化在表上改写后再交给解释器
+ * 变量位置取自结点上的 SlotRef，不再查符号表；名字没有解析到（slot 为 -1）的结点不生成访问指令
+ * 常量折叠（const_fold.h）标过 isConst 的右值表达式只生成一条 PUSH
+ * 标号计数随生成器对象，每个程序用一个新的 CodeGenerator
+ */
+class CodeGenerator {
+public:
+    vector<PCodeLine> generate(const ASTNode* root);
+
+private:
+    vector<PCodeLine> code;
+    int labelfor_bk_ctn = 0; // for 的标号序号
+    int if_order = 0;
+    int break_continu = 0;   // break/continue 跳到的 for 标号
+    int shortvalorder = 0;   // 短路求值的标号序号
+
+    void gen(const ASTNode* node);
+    bool genFolded(const ASTNode* node);
+    void genConstDef(const ConstDefNode* node);
+    void genVarDef(const VarDefNode* node);
+    void genFuncDef(const FuncDefNode* node);
+    void genFuncFParams(const FuncFParamsNode* node);
+    void genMainFuncDef(const MainFuncDefNode* node);
+    void genBlock(const BlockNode* node);
+    void genLVal(const LValNode* node, bool islight = false);
+    void genUnaryExp(const UnaryExpNode* node);
+    void genFuncRParams(const FuncRParamsNode* node);
+    void genBinary(const AstList<ASTNode*>& operands, const AstList<TokenType>& operators);
+    void genShortCircuit(const AstList<ASTNode*>& operands, Opcode combine, Opcode shortJump);
+    void genFor(const ForNode* node);
+    void genSmallfor(const SmallforstmtNode* node);
+    void genReturnStmt(const ReturnStmtNode* node);
+    void genPrintfStmt(const PrintfStmtNode* node);
+    void genAssignStmt(const AssignStmtNode* node);
+    void genIfStmt(const IfStmtNode* node);
+
+    void emit(Opcode opcode, vector<string> operands = {}) {
+        code.push_back({opcode, move(operands)});
+    }
+    void label(const string& label, int scope) {
+        emit(LABEL, {label + to_string(scope)});
+    }
+    void jump(Opcode opcode, const string& label, int scope) {
+        emit(opcode, {label + to_string(scope)});
+    }
+    static string slotRef(SlotRef ref) {
+        return (ref.global ? "G" : "L") + to_string(ref.slot);
+    }
+};
+
+/*字符常量（带或不带单引号）的 ASCII 码，格式不对时返回 -1*/
+int getCharConstAscii(string_view charConst);
+
+#endif // CODEGEN_H
@@ -0,0 +1,235 @@
+#include "const_fold.h"
+#include "codegen.h"
+#include <climits>
+#include <cstdint>
+
+/*按补码回绕到 int，与解释器里 int 运算溢出的结果相同*/
+static int wrap(long long value) {
+    return static_cast<int>(static_cast<uint32_t>(value));
+}
+
+/*lhs op rhs；运行时会出错的除法不折叠*/
+static bool applyBinary(TokenType op, int lhs, int rhs, int& result) {
+    switch (op) {
+        case MULT: result = wrap((long long)lhs * rhs); return true;
+        case DIV:
+        case MOD:
+            if (rhs == 0 || (lhs == INT_MIN && rhs == -1)) {
+                return false;
+            }
+            result = op == DIV ? lhs / rhs : lhs % rhs;
+            return true;
+        case PLUS: result = wrap((long long)lhs + rhs); return true;
+        case MINU: result = wrap((long long)lhs - rhs); return true;
+        case LSS: result = lhs < rhs; return true;
+        case GRE: result = lhs > rhs; return true;
+        case LEQ: result = lhs <= rhs; return true;
+        case GEQ: result = lhs >= rhs; return true;
+        case EQL: result = lhs == rhs; return true;
+        case NEQ: result = lhs != rhs; return true;
+        default: return false;
+    }
+}
+
+template <typename Node>
+static bool markFolded(Node* node, bool folded, const int& value) {
+    if (folded) {
+        node->isConst = true;
+        node->val = value;
+    }
+    return folded;
+}
+
+template <typename Node>
+static bool readFolded(const Node* node, int& value) {
+    if (node->isConst) {
+        value = node->val;
+    }
+    return node->isConst;
+}
+
+bool isFoldedConstant(const ASTNode* node, int& value) {
+    if (!node) {
+        return false;
+    }
+    switch (node->type) {
+        case NODE_NUMBER:
+            value = static_cast<const NumberNode*>(node)->value;
+            return true;
+        case NODE_CHARACTER:
+            value = getCharConstAscii(static_cast<const CharacterNode*>(node)->value);
+            return true;
+        case NODE_LVAL: return readFolded(static_cast<const LValNode*>(node), value);
+        case NODE_UNARYEXP: return readFolded(static_cast<const UnaryExpNode*>(node), value);
+        case NODE_MULEXP: return readFolded(static_cast<const MulExpNode*>(node), value);
+        case NODE_ADDEXP: return readFolded(static_cast<const AddExpNode*>(node), value);
+        case NODE_RELEXP: return readFolded(static_cast<const RelExpNode*>(node), value);
+        case NODE_EQEXP: return readFolded(static_cast<const EqExpNode*>(node), value);
+        case NODE_LANDEXP: return readFolded(static_cast<const LandExpNode*>(node), value);
+        case NODE_LOREXP: return readFolded(static_cast<const LorExpNode*>(node), value);
+        default: return false;
+    }
+}
+
+FoldStats ConstantFolder::fold(ASTNode* root) {
+    stats = FoldStats();
+    int value;
+    visit(root, value);
+    return stats;
+}
+
+/*后序遍历：子表达式先折叠，语句等其余结点只往下走；返回 node 作为右值是否是常数
+ * 先求出是否折叠再标注：value 只在折叠时写入*/
+bool ConstantFolder::visit(ASTNode* node, int& value) {
+    if (!node) {
+        return false;
+    }
+    switch (node->type) {
+        case NODE_NUMBER:
+        case NODE_CHARACTER:
+            return isFoldedConstant(node, value);
+        case NODE_LVAL: {
+            auto lval = static_cast<LValNode*>(node);
+            bool folded = foldLVal(lval, value);
+            return markFolded(lval, folded, value);
+        }
+        case NODE_UNARYEXP: {
+            auto exp = static_cast<UnaryExpNode*>(node);
+            bool folded = foldUnary(exp, value);
+            return markFolded(exp, folded, value);
+        }
+        case NODE_MULEXP: {
+            auto exp = static_cast<MulExpNode*>(node);
+            bool folded = foldBinary(exp->operands, exp->operators, value);
+            return markFolded(exp, folded, value);
+        }
+        case NODE_ADDEXP: {
+            auto exp = static_cast<AddExpNode*>(node);
+            bool folded = foldBinary(exp->operands, exp->operators, value);
+            return markFolded(exp, folded, value);
+        }
+        case NODE_RELEXP: {
+            auto exp = static_cast<RelExpNode*>(node);
+            bool folded = foldBinary(exp->operands, exp->operators, value);
+            return markFolded(exp, folded, value);
+        }
+        case NODE_EQEXP: {
+            auto exp = static_cast<EqExpNode*>(node);
+            bool folded = foldBinary(exp->operands, exp->operators, value);
+            return markFolded(exp, folded, value);
+        }
+        case NODE_LANDEXP: {
+            auto exp = static_cast<LandExpNode*>(node);
+            bool folded = foldLogical(exp->operands, true, value);
+            return markFolded(exp, folded, value);
+        }
+        case NODE_LOREXP: {
+            auto exp = static_cast<LorExpNode*>(node);
+            bool folded = foldLogical(exp->operands, false, value);
+            return markFolded(exp, folded, value);
+        }
+        default:
+            visitChildren(node, [&](ASTNode* child) {
+                int unused;
+                visit(child, unused);
+            });
+            return false;
+    }
+}
+
+/*const 定义在使用之前，先序遍历到这里时定义的初值已经折叠过*/
+bool ConstantFolder::foldLVal(LValNode* node, int& value) {
+    int index = 0;
+    bool constIndex = visit(node->indice, index);
+    const ConstDefNode* def = node->constDef;
+    if (!def) {
+        return false;
+    }
+    if (!def->arraysize) {
+        if (node->indice || def->initVals.empty() || !isFoldedConstant(def->initVals[0], value)) {
+            return false;
+        }
+    } else {
+        int size;
+        if (!constIndex || !isFoldedConstant(def->arraysize, size) || index < 0 || index >= size) {
+            return false;
+        }
+        if (index >= (int)def->initVals.size()) {
+            value = 0; // STORE_arraysize 清零的元素
+        } else if (!isFoldedConstant(def->initVals[index], value)) {
+            return false;
+        }
+    }
+    if (def->constdeftype.find("Char") != string_view::npos) {
+        value %= 128; // 与存入 char 变量时相同
+    }
+    stats.propagated++;
+    return true;
+}
+
+bool ConstantFolder::foldUnary(UnaryExpNode* node, int& value) {
+    int operand;
+    if (!visit(node->unaryexp, operand)) {
+        return false;
+    }
+    switch (node->unaryop) {
+        case PLUS: value = operand; break;
+        case MINU: value = wrap(-(long long)operand); break;
+        case NOT: value = !operand; break;
+        default: value = operand; return true;
+    }
+    stats.operations++;
+    return true;
+}
+
+/*左结合，操作数全是常数才折叠；每个操作数都要访问，里面的子表达式还可以各自折叠*/
+bool ConstantFolder::foldBinary(AstList<ASTNode*>& operands, const AstList<TokenType>& operators, int& value) {
+    bool folded = true;
+    for (size_t i = 0; i < operands.size(); i++) {
+        int operand;
+        if (!visit(operands[i], operand)) {
+            folded = false;
+        } else if (folded && i == 0) {
+            value = operand;
+        } else if (folded) {
+            folded = applyBinary(operators[i - 1], value, operand, value);
+            stats.operations += folded;
+        }
+    }
+    return folded;
+}
+
+/*
+ * 只有一个操作数时原样取它的值；多个操作数时按生成的指令逐个合并（解释器的 AnD/O_R 得 0/1），
+ * 前面全是常数、合并结果已经满足短路跳转条件时后面的操作数不会求值，结果已定
+ * 短路跳转与解释器一致：&& 在结果为 0 时跳，|| 只在结果恰好为 1 时跳，所以 2 || f() 仍会调用 f
+ */
+bool ConstantFolder::foldLogical(AstList<ASTNode*>& operands, bool isAnd, int& value) {
+    if (operands.size() == 1) {
+        return visit(operands[0], value);
+    }
+    bool prefixConst = true;
+    bool decided = false;
+    for (size_t i = 0; i < operands.size(); i++) {
+        int operand;
+        bool isConst = visit(operands[i], operand);
+        if (!prefixConst || decided) {
+            continue;
+        }
+        if (!isConst) {
+            prefixConst = false;
+            continue;
+        }
+        if (i == 0) {
+            value = operand;
+        } else {
+            value = isAnd ? (value && operand) : (value || operand);
+        }
+        decided = isAnd ? value == 0 : value == 1;
+    }
+    if (!prefixConst && !decided) {
+        return false;
+    }
+    stats.operations += operands.size() - 1;
+    return true;
+}
@@ -0,0 +1,38 @@
+#ifndef CONST_FOLD_H
+#define CONST_FOLD_H
+
+#include <cstddef>
+#include "ast.h"
+
+using namespace std;
+
+struct FoldStats {
+    size_t operations = 0; // 编译时求值的运算符个数
+    size_t propagated = 0; // 换成 const 定义初值的 LVal 个数
+};
+
+/*
+ * 常量折叠与传播：语义分析之后、代码生成之前，把值不依赖运行时的表达式求出来，
+ * 写到结点的 val 并置 isConst，代码生成对这样的结点只压一个常数
+ * 引用 const 标量、或以常量下标引用 const 数组的 LVal 换成定义里的初值（数组长度内没有初值的元素为 0）
+ * 求值与解释器一致：int 按补码回绕，比较和逻辑运算得 0/1，char 常量取存入时的 % 128；
+ * 除数为 0 和 INT_MIN / -1 留到运行时，不折叠
+ */
+class ConstantFolder {
+public:
+    FoldStats fold(ASTNode* root);
+
+private:
+    FoldStats stats;
+
+    bool visit(ASTNode* node, int& value);
+    bool foldLVal(LValNode* node, int& value);
+    bool foldUnary(UnaryExpNode* node, int& value);
+    bool foldBinary(AstList<ASTNode*>& operands, const AstList<TokenType>& operators, int& value);
+    bool foldLogical(AstList<ASTNode*>& operands, bool isAnd, int& value);
+};
+
+/*结点作为右值是否已折叠成常数 value；Number、Character 也算*/
+bool isFoldedConstant(const ASTNode* node, int& value);
+
+#endif // CONST_FOLD_H
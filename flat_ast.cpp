@@ -0,0 +1,143 @@
+#include "flat_ast.h"
+
+/*先序递归转换；每个结点先占好自己的子结点表，再依次转换子结点填进去*/
+class FlatAstBuilder {
+public:
+    FlatAst ast;
+
+    uint32_t add(const ASTNode* node) {
+        if (!node) {
+            return FLAT_NONE;
+        }
+        uint32_t childCount = 0;
+        visitChildren(node, [&](const ASTNode*) { childCount++; });
+
+        uint32_t index = (uint32_t)ast.nodes.size();
+        uint32_t firstChild = (uint32_t)ast.childIndices.size();
+        ast.nodes.push_back({node->type, 0, 0, firstChild, childCount, 0, 0, 0});
+        ast.childIndices.resize(firstChild + childCount, FLAT_NONE);
+        setPayload(index, node);
+
+        uint32_t slot = firstChild;
+        visitChildren(node, [&](const ASTNode* child) {
+            uint32_t childIndex = add(child); // 可能让 childIndices 扩容，先转换再写入
+            ast.childIndices[slot++] = childIndex;
+        });
+        ast.nodes[index].subtreeEnd = (uint32_t)ast.nodes.size();
+        return index;
+    }
+
+private:
+    /*行号、标志和 a、b，布局见 flat_ast.h*/
+    void setPayload(uint32_t index, const ASTNode* node) {
+        FlatNode& flat = ast.nodes[index];
+        switch (node->type) {
+            case NODE_COMPUNIT: {
+                auto n = static_cast<const CompUnitNode*>(node);
+                flat.a = (int32_t)n->decls.size();
+                flat.b = (int32_t)n->funcDefs.size();
+                break;
+            }
+            case NODE_CONSTDEF: {
+                auto n = static_cast<const ConstDefNode*>(node);
+                setNamed(flat, n->linenum, n->name, n->constdeftype);
+                break;
+            }
+            case NODE_VARDEF: {
+                auto n = static_cast<const VarDefNode*>(node);
+                setNamed(flat, n->linenum, n->name, n->vardeftype);
+                break;
+            }
+            case NODE_FUNCDEF: {
+                auto n = static_cast<const FuncDefNode*>(node);
+                setNamed(flat, n->linenum, n->name, n->funcdeftype);
+                break;
+            }
+            case NODE_FUNCFPARAM: {
+                auto n = static_cast<const FuncFParamNode*>(node);
+                setNamed(flat, n->linenum, n->name, n->realtype);
+                flat.flags = n->isArray ? FLAT_IS_ARRAY : 0;
+                break;
+            }
+            case NODE_BLOCK: {
+                auto n = static_cast<const BlockNode*>(node);
+                flat.line = n->end_linenum;
+                flat.flags = n->isfor ? FLAT_BLOCK_IS_FOR : 0;
+                break;
+            }
+            case NODE_LVAL: {
+                auto n = static_cast<const LValNode*>(node);
+                flat.line = n->linenum;
+                flat.a = (int32_t)n->name;
+                flat.flags = n->maybeisarray ? FLAT_MAYBE_ARRAY : 0;
+                break;
+            }
+            case NODE_UNARYEXP:
+                flat.a = static_cast<const UnaryExpNode*>(node)->unaryop;
+                break;
+            case NODE_FUNCRPARAMS: {
+                auto n = static_cast<const FuncRParamsNode*>(node);
+                flat.line = n->linenum;
+                flat.a = (int32_t)n->name;
+                break;
+            }
+            case NODE_MULEXP: setOperators(flat, static_cast<const MulExpNode*>(node)->operators); break;
+            case NODE_ADDEXP: setOperators(flat, static_cast<const AddExpNode*>(node)->operators); break;
+            case NODE_RELEXP: setOperators(flat, static_cast<const RelExpNode*>(node)->operators); break;
+            case NODE_EQEXP: setOperators(flat, static_cast<const EqExpNode*>(node)->operators); break;
+            case NODE_LANDEXP: setOperators(flat, static_cast<const LandExpNode*>(node)->operators); break;
+            case NODE_LOREXP: setOperators(flat, static_cast<const LorExpNode*>(node)->operators); break;
+            case NODE_NUMBER:
+                flat.a = static_cast<const NumberNode*>(node)->value;
+                break;
+            case NODE_CHARACTER:
+                flat.a = addText(static_cast<const CharacterNode*>(node)->value);
+                break;
+            case NODE_RETURNSTMT:
+                flat.line = static_cast<const ReturnStmtNode*>(node)->linenum;
+                break;
+            case NODE_BREAKSTMT:
+                flat.line = static_cast<const BreakStmtNode*>(node)->breaklinenum;
+                break;
+            case NODE_CONTINUESTMT:
+                flat.line = static_cast<const ContinueStmtNode*>(node)->continuelinenum;
+                break;
+            case NODE_PRINTFSTMT: {
+                auto n = static_cast<const PrintfStmtNode*>(node);
+                flat.line = n->printlinenum;
+                flat.a = addText(n->format);
+                break;
+            }
+            case NODE_ASSIGNSTMT: {
+                auto n = static_cast<const AssignStmtNode*>(node);
+                flat.flags = (n->getint ? FLAT_GETINT : 0) | (n->getchar ? FLAT_GETCHAR : 0);
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    void setNamed(FlatNode& flat, int line, IdentId name, string_view type) {
+        flat.line = line;
+        flat.a = (int32_t)name;
+        flat.b = addText(type);
+    }
+
+    void setOperators(FlatNode& flat, const AstList<TokenType>& operators) {
+        flat.a = (int32_t)ast.operators.size();
+        ast.operators.insert(ast.operators.end(), operators.begin(), operators.end());
+    }
+
+    int32_t addText(string_view text) {
+        ast.textRanges.push_back({(uint32_t)ast.textPool.size(), (uint32_t)text.size()});
+        ast.textPool.append(text);
+        return (int32_t)ast.textRanges.size() - 1;
+    }
+};
+
+FlatAst flattenAst(const ASTNode* root) {
+    FlatAstBuilder builder;
+    builder.add(root);
+    return move(builder.ast);
+}
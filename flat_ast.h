@@ -0,0 +1,94 @@
+#ifndef FLAT_AST_H
+#define FLAT_AST_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "ast.h"
+
+using namespace std;
+
+const uint32_t FLAT_NONE = UINT32_MAX; // 可选的子结点不存在
+
+// FlatNode::flags
+enum FlatFlag : uint8_t {
+    FLAT_IS_ARRAY = 1,       // FuncFParam 的 isArray
+    FLAT_MAYBE_ARRAY = 2,    // LVal 的 maybeisarray
+    FLAT_GETINT = 4,         // AssignStmt
+    FLAT_GETCHAR = 8,        // AssignStmt
+    FLAT_BLOCK_IS_FOR = 16   // Block 的 isfor
+};
+
+/*
+ * 结点按先序连续存放，下标就是结点编号；子结点编号按顺序放在 children 的 [firstChild, firstChild + childCount)
+ * 可选的子结点（数组长度、else 分支、for 的三个部分等）占位置，不存在时为 FLAT_NONE
+ * subtreeEnd 是子树之后第一个结点的编号，跳过整棵子树只需把下标移到这里
+ *
+ * 各类结点的子结点和 a、b：
+ *   CompUnit      decls..., funcDefs..., mainFuncDef    a = decls 个数，b = funcDefs 个数
+ *   ConstDef      arraysize, initVals...                 a = 名字，b = 类型（texts 下标）
+ *   VarDef        arraysize, initVals...                 a = 名字，b = 类型
+ *   FuncDef       params, block                          a = 名字，b = 类型
+ *   FuncFParam    无                                     a = 名字，b = 类型
+ *   LVal          indice                                 a = 名字
+ *   FuncRParams   实参...                                a = 名字
+ *   UnaryExp      unaryexp                               a = 运算符（TokenType）
+ *   Mul/Add/Rel/Eq/Land/LorExp  operands...              a = operators 中第一个运算符的下标，共 childCount - 1 个
+ *   Number        无                                     a = 值
+ *   Character     无                                     a = 文字（texts 下标）
+ *   PrintfStmt    args...                                a = 格式串（texts 下标）
+ *   ReturnStmt    exp；ExpStmt exp；AssignStmt lval, exp；SmallFor lval, exp
+ *   IfStmt        ifcond, thenStmt, elseStmt；For init, forcond, step, body
+ *   其余结点的子结点与原来的表一致，a、b 不用
+ * line 为原结点的行号（Block 为右花括号所在行），没有行号的结点为 0
+ */
+struct FlatNode {
+    NodeType kind;
+    uint8_t flags;
+    int line;
+    uint32_t firstChild;
+    uint32_t childCount;
+    uint32_t subtreeEnd;
+    int32_t a;
+    int32_t b;
+};
+
+struct FlatChildren {
+    const uint32_t* first;
+    const uint32_t* last;
+    const uint32_t* begin() const { return first; }
+    const uint32_t* end() const { return last; }
+    size_t size() const { return last - first; }
+    uint32_t operator[](size_t i) const { return first[i]; }
+};
+
+/*扁平的语法树：结点、子结点表和各种载荷都在连续的数组里，不指向原树，可以比原树活得久*/
+class FlatAst {
+public:
+    size_t size() const { return nodes.size(); }
+    const FlatNode& operator[](uint32_t i) const { return nodes[i]; }
+    FlatChildren children(uint32_t i) const {
+        const uint32_t* first = childIndices.data() + nodes[i].firstChild;
+        return {first, first + nodes[i].childCount};
+    }
+    string_view text(int32_t index) const {
+        return string_view(textPool).substr(textRanges[index].first, textRanges[index].second);
+    }
+    TokenType op(int32_t index) const { return operators[index]; }
+
+private:
+    friend class FlatAstBuilder;
+
+    vector<FlatNode> nodes;
+    vector<uint32_t> childIndices;
+    vector<TokenType> operators;
+    string textPool; // 文字从 arena 复制出来，转换后与原树无关
+    vector<pair<uint32_t, uint32_t>> textRanges; // textPool 中的偏移和长度
+};
+
+/*把 ASTNode 树转换成 FlatAst；root 为空时得到空树*/
+FlatAst flattenAst(const ASTNode* root);
+
+#endif // FLAT_AST_H
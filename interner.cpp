@@ -0,0 +1,3 @@
+#include "interner.h"
+
+Interner identifiers;
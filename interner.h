@@ -0,0 +1,70 @@
+#ifndef INTERNER_H
+#define INTERNER_H
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+typedef uint32_t IdentId;
+
+/*
+ * 标识符驻留表：每个不同的标识符在词法分析时得到一个 32 位编号，名字只存一份
+ * Token、AST、符号表都只保存编号，比较名字就是比较整数；需要文字时用 name(id) 取回
+ * 编号 0 固定为空名字，表只增不减，取回的 string_view 一直有效
+ */
+class Interner {
+public:
+    Interner() { intern(""); }
+    Interner(const Interner&) = delete;
+    Interner& operator=(const Interner&) = delete;
+
+    IdentId intern(string_view text) {
+        auto it = ids.find(text);
+        if (it != ids.end()) {
+            return it->second;
+        }
+        string_view stored = store(text);
+        IdentId id = (IdentId)names.size();
+        names.push_back(stored);
+        ids.emplace(stored, id);
+        return id;
+    }
+
+    string_view name(IdentId id) const { return names[id]; }
+    size_t size() const { return names.size(); }
+
+private:
+    static constexpr size_t blockSize = 64 * 1024;
+
+    /*名字按顺序放进大块内存，块不移动，所以 names 和 ids 里的 string_view 不会失效*/
+    string_view store(string_view text) {
+        if (text.empty()) {
+            return string_view();
+        }
+        if (text.size() > blockCapacity - blockUsed) {
+            blockCapacity = max(blockSize, text.size());
+            blocks.emplace_back(new char[blockCapacity]);
+            blockUsed = 0;
+        }
+        char* data = blocks.back().get() + blockUsed;
+        text.copy(data, text.size());
+        blockUsed += text.size();
+        return string_view(data, text.size());
+    }
+
+    unordered_map<string_view, IdentId> ids;
+    vector<string_view> names;
+    vector<unique_ptr<char[]>> blocks;
+    size_t blockCapacity = 0;
+    size_t blockUsed = 0;
+};
+
+// 全局的标识符表，各阶段共用
+extern Interner identifiers;
+
+#endif // INTERNER_H
@@ -2,34 +2,6 @@
 #include "ast.h"
 #include "parser.h"
 
-// 单词类别码映射
-unordered_map<string, TokenType> tokenMap = {
-    {"const", CONSTTK}, {"int", INTTK}, {"char", CHARTK}, {"void", VOIDTK},
-    {"main", MAINTK}, {"if", IFTK}, {"else", ELSETK}, {"for", FORTK},
-    {"break", BREAKTK}, {"continue", CONTINUETK}, {"return", RETURNTK},
-    {"+", PLUS}, {"-", MINU}, {"*", MULT}, {"/", DIV}, {"%", MOD},
-    {"<", LSS}, {"<=", LEQ}, {">", GRE}, {">=", GEQ}, {"==", EQL},
-    {"!=", NEQ}, {"=", ASSIGN}, {";", SEMICN}, {",", COMMA},
-    {"(", LPARENT}, {")", RPARENT}, {"[", LBRACK}, {"]", RBRACK},
-    {"{", LBRACE}, {"}", RBRACE}, {"&&", AND}, {"||", OR}, {"!", NOT},
-    {"getint", GETINTTK}, {"getchar", GETCHARTK}, {"printf", PRINTFTK}
-};
-
-// 单词类别码字符串映射
-unordered_map<TokenType, string> tokenTypeMap = {
-    {CONSTTK, "CONSTTK"}, {INTTK, "INTTK"}, {CHARTK, "CHARTK"}, {VOIDTK, "VOIDTK"},
-    {MAINTK, "MAINTK"}, {IFTK, "IFTK"}, {ELSETK, "ELSETK"}, {FORTK, "FORTK"},
-    {BREAKTK, "BREAKTK"}, {CONTINUETK, "CONTINUETK"}, {RETURNTK, "RETURNTK"},
-    {PLUS, "PLUS"}, {MINU, "MINU"}, {MULT, "MULT"}, {DIV, "DIV"}, {MOD, "MOD"},
-    {LSS, "LSS"}, {LEQ, "LEQ"}, {GRE, "GRE"}, {GEQ, "GEQ"}, {EQL, "EQL"},
-    {NEQ, "NEQ"}, {ASSIGN, "ASSIGN"}, {SEMICN, "SEMICN"}, {COMMA, "COMMA"},
-    {LPARENT, "LPARENT"}, {RPARENT, "RPARENT"}, {LBRACK, "LBRACK"}, {RBRACK, "RBRACK"},
-    {LBRACE, "LBRACE"}, {RBRACE, "RBRACE"}, {AND, "AND"}, {OR, "OR"}, {NOT, "NOT"},
-    {IDENFR, "IDENFR"}, {INTCON, "INTCON"}, {STRCON, "STRCON"}, {CHRCON, "CHRCON"},
-    {GETINTTK, "GETINTTK"}, {GETCHARTK, "GETCHARTK"}, {PRINTFTK, "PRINTFTK"},
-    {UNKNOWN, "UNKNOWN"}
-};
-
 // 错误类别码映射
 unordered_map<ErrorType, string> errorMap = {
     {ERROR_UNKNOWN_TOKEN, "ERROR_UNKNOWN_TOKEN"},
@@ -40,79 +12,98 @@ Lexer::Lexer(const string& inputFile, const string& lexerOutputFile, const strin
     : inputFile(inputFile), lexerOutputFile(lexerOutputFile), errorOutputFile(errorOutputFile) {}
 
 void Lexer::analyze() {
+    if (!sourceFile.open(inputFile)) {
+        cerr << "Error: Could not open " << inputFile << endl;
+    }
+    analyzeSource(sourceFile.text());
+}
+
+void Lexer::analyzeSource(string_view source) {
     openFiles();
-    char ch;
+    lineNumber = 1;
+    errors.clear();
+    errorLines.clear();
+    tokens.reset(source.data());
+    cur = source.data();
+    end = cur + source.size();
     skipWhitespace();
-    while (input.get(ch)) {
-        if (ch == '\n') {
-            lineNumber++;
-        }
-        if (isspace(ch)) {
+    while (cur < end) {
+        unsigned char ch = *cur;
+        if (isspace(ch) || (ch == '/' && cur + 1 < end && (cur[1] == '/' || cur[1] == '*'))) {
             skipWhitespace();
             continue;
         }
         if (isalpha(ch) || ch == '_') {
-            input.unget();
-            string identifier = readIdentifier();
+            string_view identifier = readIdentifier();
             TokenType type = getTokenType(identifier);
             if (type == UNKNOWN) {
                 processError(ERROR_UNKNOWN_TOKEN);
             } else {
-                processToken(identifier, type);
+                processToken(identifier, type, type == IDENFR ? identifiers.intern(identifier) : 0);
             }
         } else if (isdigit(ch)) {
-            input.unget();
-            string number = readNumber();
-            processToken(number, INTCON);
+            processToken(readNumber(), INTCON);
         } else if (ch == '"') {
-            string str = readString();
-            processToken(str, STRCON);
+            processToken(readString(), STRCON);
         } else if (ch == '\'') {
-            string chr = readChar();
-            processToken(chr, CHRCON);
+            processToken(readChar(), CHRCON);
         } else {
-            string token;
-            token += ch;
-            char nextCh;
-            input.get(nextCh);
+            const char* start = cur++;
+            char nextCh = cur < end ? *cur : '\0';
 
             // 检查是否构成多字符运算符
             if (ch == '&' ) {
                 if(nextCh == '&') {
-                    token += nextCh;
-                    processToken(token, AND);
+                    cur++;
+                    processToken(string_view(start, 2), AND);
                 } else {
-                    token += '&';
-                    processToken(token, AND);
+                    processToken("&&", AND);
                     processError("a");
-                    input.unget();
                 }
             } else if (ch == '|') {
                 if(nextCh == '|') {
-                    token += nextCh;
-                    processToken(token, OR);
+                    cur++;
+                    processToken(string_view(start, 2), OR);
                 } else {
-                    token += '|';
-                    processToken(token, OR);
+                    processToken("||", OR);
                     processError("a");
-                    input.unget();
                 }
             } else if (ch == '<' && nextCh == '=') {
-                token += nextCh;
-                processToken(token, LEQ);
+                cur++;
+                processToken(string_view(start, 2), LEQ);
             } else if (ch == '>' && nextCh == '=') {
-                token += nextCh;
-                processToken(token, GEQ);
+                cur++;
+                processToken(string_view(start, 2), GEQ);
             } else if (ch == '!' && nextCh == '=') {
-                token += nextCh;
-                processToken(token, NEQ);
+                cur++;
+                processToken(string_view(start, 2), NEQ);
             } else if (ch == '=' && nextCh == '=') {
-                token += nextCh;
-                processToken(token, EQL);
+                cur++;
+                processToken(string_view(start, 2), EQL);
             } else {
-                input.unget(); // 回退一个字符
-                if (tokenMap.find(token) != tokenMap.end()) {
-                    processToken(token, tokenMap[token]);
+                TokenType type = UNKNOWN;
+                switch (ch) {
+                    case '+': type = PLUS; break;
+                    case '-': type = MINU; break;
+                    case '*': type = MULT; break;
+                    case '/': type = DIV; break;
+                    case '%': type = MOD; break;
+                    case '<': type = LSS; break;
+                    case '>': type = GRE; break;
+                    case '=': type = ASSIGN; break;
+                    case ';': type = SEMICN; break;
+                    case ',': type = COMMA; break;
+                    case '(': type = LPARENT; break;
+                    case ')': type = RPARENT; break;
+                    case '[': type = LBRACK; break;
+                    case ']': type = RBRACK; break;
+                    case '{': type = LBRACE; break;
+                    case '}': type = RBRACE; break;
+                    case '!': type = NOT; break;
+                    default: break;
+                }
+                if (type != UNKNOWN) {
+                    processToken(string_view(start, 1), type);
                 } else {
                     processError(ERROR_UNEXPECTED_CHAR);
                 }
@@ -123,20 +114,31 @@ void Lexer::analyze() {
 }
 
 void Lexer::openFiles() {
-    input.open(inputFile);
-    lexerOutput.open(lexerOutputFile);
-    errorOutput.open(errorOutputFile);
+    if (!lexerOutputFile.empty()) {
+        lexerOutput.open(lexerOutputFile);
+    }
+    if (!errorOutputFile.empty()) {
+        errorOutput.open(errorOutputFile);
+    }
 }
 
 void Lexer::closeFiles() {
-    input.close();
-    lexerOutput.close();
-    errorOutput.close();
+    if (lexerOutput.is_open()) {
+        lexerOutput.close();
+    }
+    if (errorOutput.is_open()) {
+        for (const auto& line : errorLines) {
+            errorOutput << line << endl;
+        }
+        errorOutput.close();
+    }
 }
 
-void Lexer::processToken(const string& token, TokenType type) {
-    tokens.push_back({type, token, lineNumber});
-    lexerOutput << tokenTypeMap[type] << " " << token << " " << lineNumber << endl;
+void Lexer::processToken(string_view token, TokenType type, IdentId id) {
+    tokens.push(type, lineNumber, token, id);
+    if (lexerOutput.is_open()) {
+        lexerOutput << tokenTypeMap[type] << " " << token << " " << lineNumber << '\n';
+    }
 }
 
 void Lexer::processError(ErrorType error) {
@@ -144,80 +146,136 @@ void Lexer::processError(ErrorType error) {
 }
 
 void Lexer::processError(string error) {
-    errorOutput << lineNumber << " " << error << endl;
+    errorLines.push_back(to_string(lineNumber) + " " + error);
 }
 
+/*跳过空白和注释，注释中的换行照常计入行号；未结束的块注释延续到文件尾*/
 void Lexer::skipWhitespace() {
-    char ch;
-    while (input.get(ch)) {
-        if (isspace(ch)) {
-            if (ch == '\n') {
-                lineNumber++;
+    while (cur < end) {
+        if (isspace((unsigned char)*cur)) {
+            cur = scan->skipSpaces(cur, end, lineNumber);
+        } else if (*cur == '/' && cur + 1 < end && cur[1] == '/') {
+            // 单行注释，换行符留给下一轮
+            cur += 2;
+            while (cur < end && *cur != '\n') {
+                cur++;
+            }
+        } else if (*cur == '/' && cur + 1 < end && cur[1] == '*') {
+            cur += 2;
+            while (cur < end && !(*cur == '*' && cur + 1 < end && cur[1] == '/')) {
+                if (*cur == '\n') {
+                    lineNumber++;
+                }
+                cur++;
             }
+            cur = min(cur + 2, end);
         } else {
-            input.unget(); // 不是空白字符或注释，回退一个字符
             break;
         }
     }
 }
 
-string Lexer::readIdentifier() {
-    string identifier;
-    char ch;
-    while (input.get(ch) && (isalnum(ch) || ch == '_')) {
-        identifier += ch;
-    }
-    if (input) input.unget();
-    return identifier;
+string_view Lexer::readIdentifier() {
+    const char* start = cur;
+    cur = scan->identifierEnd(cur, end);
+    return string_view(start, cur - start);
 }
 
-string Lexer::readNumber() {
-    string number;
-    char ch;
-    while (input.get(ch) && isdigit(ch)) {
-        number += ch;
-    }
-    if (input) input.unget();
-    return number;
+string_view Lexer::readNumber() {
+    const char* start = cur;
+    cur = scan->digitsEnd(cur, end);
+    return string_view(start, cur - start);
 }
 
-string Lexer::readString() {
-    string str;
-    char ch;
-    str += '"';
-    while (input.get(ch) && ch != '"') {
-        str += ch;
+/*连同首尾双引号；没有结尾引号时读到文件尾*/
+string_view Lexer::readString() {
+    const char* start = cur++;
+    while (cur < end && *cur != '"') {
+        cur++;
     }
-    if (ch == '"') {
-        str += ch; // 保留结尾的双引号
+    if (cur < end) {
+        cur++; // 保留结尾的双引号
     }
-    return str;
+    return string_view(start, cur - start);
 }
 
-string Lexer::readChar() {
-    string chr;
-    char ch;
-    chr += '\'';
-    input.get(ch); // 读取字符
-    if (ch == '\\') {
-        // 处理转义字符
-        chr += ch;
-        input.get(ch);
+/*连同首尾单引号，'\x' 形式的转义字符原样保留*/
+string_view Lexer::readChar() {
+    const char* start = cur++;
+    if (cur < end && *cur == '\\') {
+        cur++; // 处理转义字符
     }
-    chr += ch;
-    input.get(ch); // 跳过结尾的单引号
-    chr += '\'';
-    return chr;
+    cur = min(cur + 2, end); // 字符和结尾的单引号
+    return string_view(start, cur - start);
 }
 
-TokenType Lexer::getTokenType(const string& token) {
-    if (tokenMap.find(token) != tokenMap.end()) {
-        return tokenMap[token];
-    } else if (isdigit(token[0])) {
+TokenType Lexer::getTokenType(string_view token) {
+    if (isdigit((unsigned char)token[0])) {
         return INTCON;
-    } else if (isalpha(token[0]) || token[0] == '_') {
-        return IDENFR;
+    } else if (isalpha((unsigned char)token[0]) || token[0] == '_') {
+        return keywordType(token);
     } else {
         return UNKNOWN;
     }
 }
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+bool SourceFile::open(const string& filename) {
+    close();
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st{};
+    if (fstat(fd, &st) != 0) {
+        ::close(fd);
+        return false;
+    }
+    if (st.st_size > 0) {
+        void* addr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr != MAP_FAILED) {
+            data = static_cast<const char*>(addr);
+            size = st.st_size;
+            mapped = true;
+        }
+    }
+    ::close(fd);
+    if (!mapped && st.st_size > 0) {
+        return false;
+    }
+    return true;
+}
+
+void SourceFile::close() {
+    if (mapped) {
+        munmap(const_cast<char*>(data), size);
+    }
+    data = nullptr;
+    size = 0;
+    mapped = false;
+    buffer.clear();
+}
+#else
+bool SourceFile::open(const string& filename) {
+    close();
+    ifstream file(filename, ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    buffer.assign(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+    data = buffer.data();
+    size = buffer.size();
+    return true;
+}
+
+void SourceFile::close() {
+    data = nullptr;
+    size = 0;
+    buffer.clear();
+}
+#endif
@@ -4,9 +4,14 @@
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 #include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include "lexer_scan.h"
+#include "interner.h"
 
 
 using namespace std;
@@ -28,50 +33,186 @@ enum ErrorType {
     // 其他错误类型
 };
 
-// 单词类别码映射
-extern unordered_map<string, TokenType> tokenMap;
+// 单词类别码字符串映射，按 TokenType 取下标
+inline constexpr string_view tokenTypeMap[] = {
+    "CONSTTK", "INTTK", "CHARTK", "VOIDTK", "MAINTK", "IFTK", "ELSETK",
+    "FORTK", "BREAKTK", "CONTINUETK", "RETURNTK", "PLUS", "MINU", "MULT",
+    "DIV", "MOD", "LSS", "LEQ", "GRE", "GEQ", "EQL", "NEQ", "ASSIGN", "SEMICN",
+    "COMMA", "LPARENT", "RPARENT", "LBRACK", "RBRACK", "LBRACE", "RBRACE",
+    "IDENFR", "INTCON", "STRCON", "CHRCON", "GETINTTK", "GETCHARTK", "PRINTFTK",
+    "AND", "OR", "NOT", "UNKNOWN"
+};
+static_assert(size(tokenTypeMap) == UNKNOWN + 1, "tokenTypeMap 与 TokenType 不一致");
+
+// 关键字表，运算符由词法分析器逐字符识别，不在表中
+struct Keyword {
+    string_view text;
+    TokenType type;
+};
+inline constexpr Keyword keywords[] = {
+    {"const", CONSTTK}, {"int", INTTK}, {"char", CHARTK}, {"void", VOIDTK},
+    {"main", MAINTK}, {"if", IFTK}, {"else", ELSETK}, {"for", FORTK},
+    {"break", BREAKTK}, {"continue", CONTINUETK}, {"return", RETURNTK},
+    {"getint", GETINTTK}, {"getchar", GETCHARTK}, {"printf", PRINTFTK}
+};
+
+/*关键字的完美哈希：长度、首字符、尾字符组合后落在 16 个槽里，各关键字互不冲突
+  增删关键字后若 static_assert 失败，需重新挑选系数*/
+constexpr unsigned keywordHash(string_view word) {
+    return (unsigned(word.size()) + (unsigned char)word.front() + (unsigned char)word.back() * 12u) & 15u;
+}
 
-// 单词类别码字符串映射
-extern unordered_map<TokenType, string> tokenTypeMap;
+struct KeywordSlots {
+    signed char index[16]; //keywords 下标，-1 为空槽
+    bool perfect;
+};
+
+constexpr KeywordSlots buildKeywordSlots() {
+    KeywordSlots slots{};
+    for (signed char& index : slots.index) {
+        index = -1;
+    }
+    slots.perfect = true;
+    for (size_t i = 0; i < size(keywords); i++) {
+        signed char& index = slots.index[keywordHash(keywords[i].text)];
+        if (index != -1) {
+            slots.perfect = false;
+        }
+        index = (signed char)i;
+    }
+    return slots;
+}
+
+inline constexpr KeywordSlots keywordSlots = buildKeywordSlots();
+static_assert(keywordSlots.perfect, "关键字哈希有冲突");
+
+/*标识符是关键字时返回其类别码，否则返回 IDENFR；word 不能为空
+  一次哈希加一次比较，不分配内存*/
+constexpr TokenType keywordType(string_view word) {
+    if (word.size() < 2 || word.size() > 8) {
+        return IDENFR;
+    }
+    int index = keywordSlots.index[keywordHash(word)];
+    return index >= 0 && keywords[index].text == word ? keywords[index].type : IDENFR;
+}
+static_assert(keywordType("getchar") == GETCHARTK && keywordType("get") == IDENFR && keywordType("iff") == IDENFR);
 
 // 错误类别码映射
 extern unordered_map<ErrorType, string> errorMap;
 
+/*单个单词，由 TokenStream 按下标取出；value 指向源程序缓冲区，不单独复制
+  id 是标识符在 identifiers 中的编号，其他单词为 0*/
 struct Token {
     TokenType type;
-    string value;
     int lineNumber;
+    string_view value;
+    IdentId id = 0;
+};
+
+/*
+ * 按列存放的单词序列：类别、在源程序中的偏移和长度、行号、标识符编号各占一个数组，每个单词 17 字节
+ * 文字不复制，只记偏移；单个 & 或 | 补成的 && 和 || 不在源程序里，按类别返回固定的文字
+ * source 须比 TokenStream 活得久，源程序不超过 4 GB
+ */
+class TokenStream {
+public:
+    void reset(const char* base) {
+        source = base;
+        types.clear();
+        offsets.clear();
+        lengths.clear();
+        lines.clear();
+        ids.clear();
+    }
+
+    void push(TokenType type, int line, string_view value, IdentId id) {
+        types.push_back((uint8_t)type);
+        offsets.push_back(type == AND || type == OR ? 0 : (uint32_t)(value.data() - source));
+        lengths.push_back((uint32_t)value.size());
+        lines.push_back(line);
+        ids.push_back(id);
+    }
+
+    size_t size() const { return types.size(); }
+    TokenType type(size_t i) const { return (TokenType)types[i]; }
+    int line(size_t i) const { return lines[i]; }
+    IdentId id(size_t i) const { return ids[i]; }
+    string_view value(size_t i) const {
+        switch (types[i]) {
+            case AND: return "&&";
+            case OR: return "||";
+            default: return string_view(source + offsets[i], lengths[i]);
+        }
+    }
+    Token operator[](size_t i) const { return {type(i), line(i), value(i), id(i)}; }
+
+private:
+    const char* source = nullptr;
+    vector<uint8_t> types;
+    vector<uint32_t> offsets;
+    vector<uint32_t> lengths;
+    vector<int> lines;
+    vector<IdentId> ids;
+};
+
+/*只读映射整个源文件，不支持映射的平台整体读入内存*/
+class SourceFile {
+public:
+    SourceFile() = default;
+    ~SourceFile() { close(); }
+    SourceFile(const SourceFile&) = delete;
+    SourceFile& operator=(const SourceFile&) = delete;
+
+    bool open(const string& filename);
+    void close();
+    string_view text() const { return string_view(data, size); }
+
+private:
+    const char* data = nullptr;
+    size_t size = 0;
+    bool mapped = false;
+    string buffer;
 };
 
+/*输出文件名为空时不写对应的文件*/
 class Lexer {
 public:
     Lexer(const string& inputFile, const string& lexerOutputFile, const string& errorOutputFile);
-    void analyze();
-    vector<Token> getTokens() const { return tokens; }
+    void analyze(); //映射inputFile后分析，Token指向映射的内容
+    void analyzeSource(string_view source); //直接分析内存中的源程序，Token指向source；每次分析重新开始，单词、行号和错误都清空
+    const TokenStream& getTokens() const { return tokens; } //借用，Lexer 须比使用者活得久
+    TokenStream takeTokens() { return move(tokens); }
     vector<pair<int, string>> getErrors() const { return errors; }
+    const vector<string>& getErrorLines() const { return errorLines; } //"行号 错误码"
+    void setBackend(LexerBackend backend) { scan = &scanKernels(backend); } //默认 LEXER_AUTO
+    const ScanKernels& backend() const { return *scan; }
 
 private:
     string inputFile;
     string lexerOutputFile;
     string errorOutputFile;
-    ifstream input;
+    SourceFile sourceFile;
+    const char* cur = nullptr; //扫描位置
+    const char* end = nullptr;
+    const ScanKernels* scan = &scanKernels();
     ofstream lexerOutput;
     ofstream errorOutput;
     int lineNumber = 1;
-    vector<Token> tokens;
+    TokenStream tokens;
     vector<pair<int, string>> errors;
+    vector<string> errorLines;
 
     void openFiles();
     void closeFiles();
-    void processToken(const string& token, TokenType type);
+    void processToken(string_view token, TokenType type, IdentId id = 0);
     void processError(ErrorType error);
     void processError(string error);
     void skipWhitespace();
-    string readIdentifier();
-    string readNumber();
-    string readString();
-    string readChar();
-    TokenType getTokenType(const string& token);
+    string_view readIdentifier();
+    string_view readNumber();
+    string_view readString();
+    string_view readChar();
+    TokenType getTokenType(string_view token);
 };
 
-#endif // LEXER_H
\ No newline at end of file
+#endif // LEXER_H
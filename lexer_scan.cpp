@@ -0,0 +1,209 @@
+#include "lexer_scan.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define LEXER_SCAN_X86 1
+#include <immintrin.h>
+#endif
+
+/*与 C 区域的 isspace/isdigit/isalnum 一致，高位字节都不属于这几类*/
+static inline bool isSpaceByte(unsigned char ch) {
+    return ch == ' ' || (unsigned char)(ch - '\t') <= '\r' - '\t';
+}
+
+static inline bool isDigitByte(unsigned char ch) {
+    return (unsigned char)(ch - '0') <= 9;
+}
+
+static inline bool isIdentifierByte(unsigned char ch) {
+    return isDigitByte(ch) || (unsigned char)((ch | 0x20) - 'a') <= 'z' - 'a' || ch == '_';
+}
+
+static const char* skipSpacesScalar(const char* p, const char* end, int& lineNumber) {
+    while (p < end && isSpaceByte(*p)) {
+        lineNumber += *p == '\n';
+        p++;
+    }
+    return p;
+}
+
+static const char* identifierEndScalar(const char* p, const char* end) {
+    while (p < end && isIdentifierByte(*p)) {
+        p++;
+    }
+    return p;
+}
+
+static const char* digitsEndScalar(const char* p, const char* end) {
+    while (p < end && isDigitByte(*p)) {
+        p++;
+    }
+    return p;
+}
+
+#ifdef LEXER_SCAN_X86
+/*
+ * 字符类掩码：x - lo 按无符号比较不超过 hi - lo 即落在 [lo, hi] 内，
+ * SSE2 没有无符号比较，用 min(x, n) == x 代替
+ */
+static inline __m128i inRange16(__m128i bytes, char lo, char hi) {
+    __m128i offset = _mm_sub_epi8(bytes, _mm_set1_epi8(lo));
+    __m128i limit = _mm_set1_epi8(char(hi - lo));
+    return _mm_cmpeq_epi8(_mm_min_epu8(offset, limit), offset);
+}
+
+static inline unsigned spaceMask16(__m128i bytes) {
+    __m128i space = _mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(' ')), inRange16(bytes, '\t', '\r'));
+    return (unsigned)_mm_movemask_epi8(space);
+}
+
+static inline unsigned digitMask16(__m128i bytes) {
+    return (unsigned)_mm_movemask_epi8(inRange16(bytes, '0', '9'));
+}
+
+static inline unsigned identifierMask16(__m128i bytes) {
+    __m128i letter = inRange16(_mm_or_si128(bytes, _mm_set1_epi8(0x20)), 'a', 'z');
+    __m128i identifier = _mm_or_si128(_mm_or_si128(letter, inRange16(bytes, '0', '9')),
+                                      _mm_cmpeq_epi8(bytes, _mm_set1_epi8('_')));
+    return (unsigned)_mm_movemask_epi8(identifier);
+}
+
+static const char* skipSpacesSSE2(const char* p, const char* end, int& lineNumber) {
+    while (end - p >= 16) {
+        __m128i bytes = _mm_loadu_si128((const __m128i*)p);
+        unsigned stop = ~spaceMask16(bytes) & 0xFFFFu;
+        unsigned newlines = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('\n')));
+        if (stop != 0) {
+            unsigned n = __builtin_ctz(stop);
+            lineNumber += __builtin_popcount(newlines & ((1u << n) - 1));
+            return p + n;
+        }
+        lineNumber += __builtin_popcount(newlines);
+        p += 16;
+    }
+    return skipSpacesScalar(p, end, lineNumber);
+}
+
+static const char* identifierEndSSE2(const char* p, const char* end) {
+    while (end - p >= 16) {
+        unsigned stop = ~identifierMask16(_mm_loadu_si128((const __m128i*)p)) & 0xFFFFu;
+        if (stop != 0) {
+            return p + __builtin_ctz(stop);
+        }
+        p += 16;
+    }
+    return identifierEndScalar(p, end);
+}
+
+static const char* digitsEndSSE2(const char* p, const char* end) {
+    while (end - p >= 16) {
+        unsigned stop = ~digitMask16(_mm_loadu_si128((const __m128i*)p)) & 0xFFFFu;
+        if (stop != 0) {
+            return p + __builtin_ctz(stop);
+        }
+        p += 16;
+    }
+    return digitsEndScalar(p, end);
+}
+
+/*AVX2 版本只对这几个函数打开 avx2，整个程序仍可在不支持 AVX2 的机器上运行*/
+#define AVX2_TARGET __attribute__((target("avx2")))
+
+AVX2_TARGET static inline __m256i inRange32(__m256i bytes, char lo, char hi) {
+    __m256i offset = _mm256_sub_epi8(bytes, _mm256_set1_epi8(lo));
+    __m256i limit = _mm256_set1_epi8(char(hi - lo));
+    return _mm256_cmpeq_epi8(_mm256_min_epu8(offset, limit), offset);
+}
+
+AVX2_TARGET static const char* skipSpacesAVX2(const char* p, const char* end, int& lineNumber) {
+    while (end - p >= 32) {
+        __m256i bytes = _mm256_loadu_si256((const __m256i*)p);
+        __m256i space = _mm256_or_si256(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(' ')), inRange32(bytes, '\t', '\r'));
+        unsigned stop = ~(unsigned)_mm256_movemask_epi8(space);
+        unsigned newlines = (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('\n')));
+        if (stop != 0) {
+            unsigned n = __builtin_ctz(stop);
+            lineNumber += __builtin_popcount(n == 0 ? 0 : newlines & (0xFFFFFFFFu >> (32 - n)));
+            return p + n;
+        }
+        lineNumber += __builtin_popcount(newlines);
+        p += 32;
+    }
+    return skipSpacesSSE2(p, end, lineNumber);
+}
+
+AVX2_TARGET static const char* identifierEndAVX2(const char* p, const char* end) {
+    while (end - p >= 32) {
+        __m256i bytes = _mm256_loadu_si256((const __m256i*)p);
+        __m256i letter = inRange32(_mm256_or_si256(bytes, _mm256_set1_epi8(0x20)), 'a', 'z');
+        __m256i identifier = _mm256_or_si256(_mm256_or_si256(letter, inRange32(bytes, '0', '9')),
+                                             _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('_')));
+        unsigned stop = ~(unsigned)_mm256_movemask_epi8(identifier);
+        if (stop != 0) {
+            return p + __builtin_ctz(stop);
+        }
+        p += 32;
+    }
+    return identifierEndSSE2(p, end);
+}
+
+AVX2_TARGET static const char* digitsEndAVX2(const char* p, const char* end) {
+    while (end - p >= 32) {
+        unsigned stop = ~(unsigned)_mm256_movemask_epi8(inRange32(_mm256_loadu_si256((const __m256i*)p), '0', '9'));
+        if (stop != 0) {
+            return p + __builtin_ctz(stop);
+        }
+        p += 32;
+    }
+    return digitsEndSSE2(p, end);
+}
+#endif // LEXER_SCAN_X86
+
+static const ScanKernels scalarKernels = {LEXER_SCALAR, "scalar", skipSpacesScalar, identifierEndScalar, digitsEndScalar};
+#ifdef LEXER_SCAN_X86
+static const ScanKernels sse2Kernels = {LEXER_SSE2, "sse2", skipSpacesSSE2, identifierEndSSE2, digitsEndSSE2};
+static const ScanKernels avx2Kernels = {LEXER_AVX2, "avx2", skipSpacesAVX2, identifierEndAVX2, digitsEndAVX2};
+#endif
+
+bool lexerBackendSupported(LexerBackend backend) {
+    switch (backend) {
+        case LEXER_AUTO:
+        case LEXER_SCALAR:
+            return true;
+#ifdef LEXER_SCAN_X86
+        case LEXER_SSE2:
+            return __builtin_cpu_supports("sse2");
+        case LEXER_AVX2:
+            return __builtin_cpu_supports("avx2");
+#endif
+        default:
+            return false;
+    }
+}
+
+const ScanKernels& scanKernels(LexerBackend backend) {
+#ifdef LEXER_SCAN_X86
+    if ((backend == LEXER_AUTO || backend == LEXER_AVX2) && lexerBackendSupported(LEXER_AVX2)) {
+        return avx2Kernels;
+    }
+    if (backend != LEXER_SCALAR && lexerBackendSupported(LEXER_SSE2)) {
+        return sse2Kernels;
+    }
+#endif
+    (void)backend;
+    return scalarKernels;
+}
+
+bool parseLexerBackend(string_view name, LexerBackend& backend) {
+    if (name == "auto") {
+        backend = LEXER_AUTO;
+    } else if (name == "scalar") {
+        backend = LEXER_SCALAR;
+    } else if (name == "sse2") {
+        backend = LEXER_SSE2;
+    } else if (name == "avx2") {
+        backend = LEXER_AVX2;
+    } else {
+        return false;
+    }
+    return true;
+}
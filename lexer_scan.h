@@ -0,0 +1,35 @@
+#ifndef LEXER_SCAN_H
+#define LEXER_SCAN_H
+
+#include <string_view>
+
+using namespace std;
+
+/*
+ * 词法分析的字符类扫描：跳过空白、读标识符和数字的内层循环
+ * SSE2/AVX2 版本一次判断 16/32 个字节，不足一块的尾部交给标量代码
+ * LEXER_AUTO 在运行时按 CPU 支持的指令集选择最快的版本
+ */
+enum LexerBackend {
+    LEXER_AUTO,
+    LEXER_SCALAR,
+    LEXER_SSE2,
+    LEXER_AVX2
+};
+
+struct ScanKernels {
+    LexerBackend backend;
+    const char* name;
+    const char* (*skipSpaces)(const char* p, const char* end, int& lineNumber); //返回第一个非空白字符，经过的换行计入 lineNumber
+    const char* (*identifierEnd)(const char* p, const char* end); //返回第一个不是字母、数字、下划线的字符
+    const char* (*digitsEnd)(const char* p, const char* end);     //返回第一个不是数字的字符
+};
+
+/*请求的指令集不可用时依次退到 SSE2、标量*/
+const ScanKernels& scanKernels(LexerBackend backend = LEXER_AUTO);
+bool lexerBackendSupported(LexerBackend backend);
+
+/*auto、scalar、sse2、avx2*/
+bool parseLexerBackend(string_view name, LexerBackend& backend);
+
+#endif // LEXER_SCAN_H
@@ -1,48 +1,145 @@
+#include <charconv>
+#include <climits>
+#include <cstring>
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <vector>
-#include "lexer.h"
-#include "parser.h"
-#include "semantic_analyzer.h"
-#include "symbol_table.h"
-#include "shared.h"
+#include "pipeline.h"
 #include "pcode_interpreter.h"
+#include "trace.h"
 
 using namespace std;
 
-int main() {
+static const char* usage = " [--trace [file]] [--output file|-] [--output-fd n] [--output-buffer bytes]"
+                            " [--operand-stack-limit n] [--dump] [--dump-stripped] [--dump-tokens] [--dump-parse] [--dump-symbols]"
+                            " [--dump-pcode] [--dump-phase-errors] [--lexer auto|scalar|sse2|avx2] [--no-fold] [--no-peephole]";
+
+/*整个参数是 [min, max] 内的十进制整数时写入 value*/
+static bool parseNumber(const char* text, long long min, long long max, long long& value) {
+    const char* end = text + strlen(text);
+    auto result = from_chars(text, end, value);
+    return result.ec == errc() && result.ptr == end && value >= min && value <= max;
+}
+
+/*
+ * 用法：Compiler [--trace [文件]] [--output 文件|-] [--output-fd n] [--output-buffer 字节数] [--dump...]
+ * --trace 打开调试跟踪，写到单独的文件（默认 trace.txt）；跟踪须以 COMPILER_TRACE_LEVEL>0 编译
+ * --output/--output-fd 指定程序运行结果的去向（默认 pcoderesult.txt，- 为 stdout）
+ * --output-buffer 设置结果输出缓冲的大小，须为正数
+ * --operand-stack-limit 设置解释器操作数栈的容量（元素个数），1 到 2^32
+ * 结果无法打开或写出、或程序执行出错中止（如操作数栈溢出）时返回非 0
+ * --dump-xxx 写出对应的中间文件，--dump 写出全部；默认各阶段只在内存中传递
+ * --lexer 选择词法分析的扫描实现，默认 auto 按 CPU 选择
+ * --no-fold 关闭常量折叠与传播，生成未经折叠的 P-code
+ * --no-peephole 关闭代码生成后的窥孔优化
+ */
+int main(int argc, char* argv[]) {
+    string resultFile = "pcoderesult.txt";
+    int resultFd = -1;
+    size_t outputBuffer = 0;
+    size_t operandStackLimit = 0;
+    CompileOptions options;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if ((arg == "--output" || arg == "--output-fd" || arg == "--output-buffer"
+             || arg == "--operand-stack-limit" || arg == "--lexer") && i + 1 == argc) {
+            cerr << "Usage: " << argv[0] << usage << endl;
+            return 1;
+        }
+        if (arg == "--output") {
+            resultFile = argv[++i];
+            resultFd = resultFile == "-" ? 1 : -1;
+        } else if (arg == "--output-fd") {
+            long long fd;
+            if (!parseNumber(argv[++i], 0, INT_MAX, fd)) {
+                cerr << "Error: invalid --output-fd " << argv[i] << endl;
+                return 1;
+            }
+            resultFd = (int)fd;
+        } else if (arg == "--output-buffer") {
+            long long size;
+            if (!parseNumber(argv[++i], 1, LLONG_MAX, size)) {
+                cerr << "Error: invalid --output-buffer " << argv[i] << " (must be a positive number of bytes)" << endl;
+                return 1;
+            }
+            outputBuffer = (size_t)size;
+        } else if (arg == "--operand-stack-limit") {
+            long long limit;
+            if (!parseNumber(argv[++i], 1, 1LL << 32, limit)) {
+                cerr << "Error: invalid --operand-stack-limit " << argv[i] << " (must be 1 to 4294967296 elements)" << endl;
+                return 1;
+            }
+            operandStackLimit = (size_t)limit;
+        } else if (arg == "--dump") {
+            options.dumpStripped = options.dumpTokens = options.dumpParse = true;
+            options.dumpSymbols = options.dumpPCode = options.dumpPhaseErrors = true;
+        } else if (arg == "--dump-stripped") {
+            options.dumpStripped = true;
+        } else if (arg == "--dump-tokens") {
+            options.dumpTokens = true;
+        } else if (arg == "--dump-parse") {
+            options.dumpParse = true;
+        } else if (arg == "--dump-symbols") {
+            options.dumpSymbols = true;
+        } else if (arg == "--dump-pcode") {
+            options.dumpPCode = true;
+        } else if (arg == "--dump-phase-errors") {
+            options.dumpPhaseErrors = true;
+        } else if (arg == "--lexer") {
+            if (!parseLexerBackend(argv[++i], options.lexerBackend)) {
+                cerr << "Usage: " << argv[0] << usage << endl;
+                return 1;
+            }
+            if (!lexerBackendSupported(options.lexerBackend)) {
+                cerr << "Warning: " << argv[i] << " is not supported on this CPU, using " << scanKernels(options.lexerBackend).name << endl;
+            }
+        } else if (arg == "--no-fold") {
+            options.foldConstants = false;
+        } else if (arg == "--no-peephole") {
+            options.peephole = false;
+        } else if (arg == "--trace") {
+            string traceFile = (i + 1 < argc && argv[i + 1][0] != '-') ? argv[++i] : "trace.txt";
+            if (!openTrace(traceFile)) {
+                cerr << "Warning: tracing is compiled out (rebuild with -DCOMPILER_TRACE_LEVEL=1 or 2)" << endl;
+            }
+        } else {
+            cerr << "Usage: " << argv[0] << usage << endl;
+            return 1;
+        }
+    }
+
     // 读取输入文件
     ifstream inputFile("testfile.txt");
     if (!inputFile.is_open()) {
         cerr << "Error: Could not open testfile.txt" << endl;
         return 1;
     }
-    //去掉注释
-    processFile("testfile.txt", "testfile2.txt");
-    // 词法分析
-    Lexer lexer("testfile2.txt", "lexer.txt", "lexer_error.txt");
-    lexer.analyze();
-    vector<Token> tokens = lexer.getTokens();
-
-    // 语法分析
-    Parser parser(tokens, "parser.txt", "parser_error.txt");
-    unique_ptr<ASTNode> ast = parser.parse();
+    stringstream source;
+    source << inputFile.rdbuf();
+    CompileResult compiled = compileSource(source.str(), options);
 
-    
-    // 语义分析
-    SemanticAnalyzer semanticAnalyzer(ast);
-    semanticAnalyzer.analyze("symbol.txt", "symbol_error.txt", "P_code.txt");
-
-    // 合并错误信息并输出到 error.txt
-    MergeErrors();
-
-    deduplicateLines("error2.txt","error.txt");
+    // 错误信息按行号排序去重后输出到 error.txt
+    ofstream errorFile("error.txt");
+    for (const auto& line : compiled.errors) {
+        errorFile << line << '\n';
+    }
+    errorFile.close();
 
     PCodeInterpreter interpreter;
-    interpreter.run("P_code.txt","pcoderesult.txt");
+    if (outputBuffer > 0) { //0为未指定，用默认大小
+        interpreter.setOutputBufferSize(outputBuffer);
+    }
+    if (operandStackLimit > 0) { //0为未指定，用默认容量
+        interpreter.setOperandStackLimit(operandStackLimit);
+    }
+    interpreter.loadProgram(compiled.code);
+    bool ok = resultFd >= 0 ? interpreter.runLoaded(resultFd) : interpreter.runLoaded(resultFile);
+    TRACE(TRACE_PHASE, "interpreter: " << interpreter.instructionMemory().count << " instructions");
+    closeTrace();
 
     //cout<<"program have been finished"<<endl;
-    return 0;
+    return ok ? 0 : 1;
 }
 
 
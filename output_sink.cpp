@@ -0,0 +1,77 @@
+#include "output_sink.h"
+#include <charconv>
+#ifdef _WIN32
+#include <io.h>
+#define fdopen _fdopen
+#define dup _dup
+#else
+#include <unistd.h>
+#endif
+
+bool OutputSink::openFile(const string& filename) {
+    close();
+    file = fopen(filename.c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+    ownsFile = true;
+    failed = false;
+    setvbuf(file, nullptr, _IONBF, 0);
+    return true;
+}
+
+bool OutputSink::openFd(int fd) {
+    close();
+    /*dup一份再fdopen，关闭时不影响调用者的fd*/
+    int copy = dup(fd);
+    file = copy < 0 ? nullptr : fdopen(copy, "wb");
+    if (!file) {
+        return false;
+    }
+    ownsFile = true;
+    failed = false;
+    setvbuf(file, nullptr, _IONBF, 0);
+    return true;
+}
+
+bool OutputSink::close() {
+    flush();
+    if (file && ownsFile && fclose(file) != 0) {
+        failed = true;
+    }
+    file = nullptr;
+    ownsFile = false;
+    return !failed;
+}
+
+void OutputSink::flush() {
+    if (used > 0) {
+        writeThrough(buffer.data(), used);
+        used = 0;
+    }
+}
+
+void OutputSink::setBufferSize(size_t size) {
+    flush();
+    buffer.assign(size > 0 ? size : 1, 0);
+}
+
+void OutputSink::putInt(int value) {
+    if (buffer.size() - used < 16) {
+        flush();
+    }
+    if (buffer.size() < 16) {
+        char digits[16];
+        auto result = to_chars(digits, digits + sizeof(digits), value);
+        write(digits, result.ptr - digits);
+        return;
+    }
+    auto result = to_chars(buffer.data() + used, buffer.data() + buffer.size(), value);
+    used = result.ptr - buffer.data();
+}
+
+void OutputSink::writeThrough(const char* data, size_t length) {
+    if (file && fwrite(data, 1, length, file) != length) {
+        failed = true;
+    }
+}
@@ -0,0 +1,62 @@
+#ifndef OUTPUT_SINK_H
+#define OUTPUT_SINK_H
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/*输出缓冲默认大小（字节），可用 setBufferSize 修改*/
+#ifndef PCODE_OUTPUT_BUFFER_SIZE
+#define PCODE_OUTPUT_BUFFER_SIZE (1 << 20)
+#endif
+
+/*
+ * 解释器的输出：一块大的用户态缓冲，写满或关闭时整块写出
+ * 目标可以是文件、stdout 或已打开的文件描述符，底层 FILE 不再另做缓冲
+ */
+class OutputSink {
+public:
+    OutputSink() = default;
+    ~OutputSink() { close(); }
+    OutputSink(const OutputSink&) = delete;
+    OutputSink& operator=(const OutputSink&) = delete;
+
+    bool openFile(const string& filename);
+    bool openFd(int fd); //1为stdout；不接管fd，关闭时只刷新
+    bool close(); //打开以来有写失败时返回false
+    void flush();
+    void setBufferSize(size_t size);
+
+    void write(const char* data, size_t length) {
+        if (length > buffer.size() - used) {
+            flush();
+            if (length >= buffer.size()) {
+                writeThrough(data, length);
+                return;
+            }
+        }
+        memcpy(buffer.data() + used, data, length);
+        used += length;
+    }
+    void put(char c) {
+        if (used == buffer.size()) {
+            flush();
+        }
+        buffer[used++] = c;
+    }
+    void putInt(int value);
+
+private:
+    FILE* file = nullptr;
+    bool ownsFile = false;
+    bool failed = false;
+    vector<char> buffer = vector<char>(PCODE_OUTPUT_BUFFER_SIZE);
+    size_t used = 0;
+
+    void writeThrough(const char* data, size_t length);
+};
+
+#endif // OUTPUT_SINK_H
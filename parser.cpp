@@ -1,49 +1,70 @@
 #include "parser.h"
 #include "lexer.h"
 #include "ast.h"
+#include "trace.h"
+#include <charconv>
 #include <string>
 
-Parser::Parser(const vector<Token>& tokens, const string& parserOutputFile, const string& errorOutputFile)
-    : tokens(tokens), parserOutputFile(parserOutputFile), errorOutputFile(errorOutputFile) {}
+Parser::Parser(const TokenStream& tokens, const string& parserOutputFile, const string& errorOutputFile)
+    : tokens(tokens), parserOutputFile(parserOutputFile), errorOutputFile(errorOutputFile),
+      current(tokens.size() > 0 ? tokens[0] : eofToken) {}
 
-unique_ptr<ASTNode> Parser::parse() {
+/*每次分析新建一个 arena，结点都从中分配，随返回的 SyntaxTree 一起交出*/
+SyntaxTree Parser::parse() {
+    SyntaxTree ast;
+    ast.arena = make_unique<AstArena>();
+    arena = ast.arena.get();
     openFiles();
-    auto ast = compUnit();
+    ast.root = compUnit();
     closeFiles();
-    //printAST(ast.get(),0);
+    arena = nullptr;
+    //printAST(ast.root,0);
     return ast;
 }
 
 void Parser::openFiles() {
-    parserOutput.open(parserOutputFile);
-    errorOutput.open(errorOutputFile);
+    if (!parserOutputFile.empty()) {
+        parserOutput.open(parserOutputFile);
+    }
+    if (!errorOutputFile.empty()) {
+        errorOutput.open(errorOutputFile);
+    }
 }
 
 void Parser::closeFiles() {
-    parserOutput.close();
-    errorOutput.close();
+    if (parserOutput.is_open()) {
+        parserOutput.close();
+    }
+    if (errorOutput.is_open()) {
+        for (const auto& line : errorLines) {
+            errorOutput << line << endl;
+        }
+        errorOutput.close();
+    }
 }
 
-void Parser::processToken(TokenType type, const string& value) {
-    parserOutput << tokenTypeMap[type] << " " << value << endl;
+void Parser::processToken(TokenType type, string_view value) {
+    if (parserOutput.is_open()) {
+        parserOutput << tokenTypeMap[type] << " " << value << '\n';
+    }
 }
 
 void Parser::processError(int lineNumber, const string& error) {
-    errorOutput << lineNumber << " " << error << endl;
+    errorLines.push_back(to_string(lineNumber) + " " + error);
 }
 
-unique_ptr<ASTNode> Parser::compUnit() {
-    auto compUnitNode = make_unique<CompUnitNode>();
+ASTNode* Parser::compUnit() {
+    auto compUnitNode = arena->make<CompUnitNode>();
     while (currentIndex < tokens.size()) {
         if (currentToken().type == CONSTTK) {
             compUnitNode->decls.push_back(decl());
         } else if (currentToken().type == INTTK || currentToken().type == CHARTK) {
-            if (currentToken().type == INTTK && lookAhead(1).type == MAINTK) {
+            if (currentToken().type == INTTK && lookAheadType(1) == MAINTK) {
                 compUnitNode->mainFuncDef = mainFuncDef();
                 break;
             } else {
-                if (lookAhead(1).type == IDENFR && lookAhead(2).type == LPARENT) {
-                    string functype;
+                if (lookAheadType(1) == IDENFR && lookAheadType(2) == LPARENT) {
+                    string_view functype;
                     if(currentToken().type == INTTK)
                         functype = "IntFunc";
                     else if(currentToken().type == CHARTK)
@@ -56,7 +77,7 @@ unique_ptr<ASTNode> Parser::compUnit() {
         } else if (currentToken().type == VOIDTK) {
             compUnitNode->funcDefs.push_back(funcDef("VoidFunc",currentToken().lineNumber));
         } else {
-            cout<<currentToken().value<<endl;
+            TRACE(TRACE_DETAIL, "unexpected token " << currentToken().value);
             processError(currentToken().lineNumber, "Unexpected token in CompUnit");
             break;
         }
@@ -64,7 +85,7 @@ unique_ptr<ASTNode> Parser::compUnit() {
     return compUnitNode;
 }
 
-unique_ptr<ASTNode> Parser::decl() {
+ASTNode* Parser::decl() {
     if (currentToken().type == CONSTTK) {
         return constDecl();
     } else if (currentToken().type == INTTK || currentToken().type == CHARTK) {
@@ -73,15 +94,15 @@ unique_ptr<ASTNode> Parser::decl() {
     return nullptr;
 }
 
-unique_ptr<ASTNode> Parser::constDecl() {
-    string consttype;
+ASTNode* Parser::constDecl() {
+    string_view consttype;
     match(CONSTTK);
     if(currentToken().type == INTTK)
         consttype = "ConstInt";
     else if(currentToken().type == CHARTK)
         consttype = "ConstChar";
     match(currentToken().type); // INTTK or CHARTK
-    auto constDeclNode = make_unique<ConstDeclNode>();
+    auto constDeclNode = arena->make<ConstDeclNode>();
     if (currentToken().type == IDENFR) {
         constDeclNode->constDefs.push_back(constDef(consttype,currentToken().lineNumber));
     }
@@ -93,26 +114,26 @@ unique_ptr<ASTNode> Parser::constDecl() {
     return constDeclNode;
 }
 
-unique_ptr<ASTNode> Parser::constDef(string type,int line) {
-    auto constDefNode = make_unique<ConstDefNode>();
-    constDefNode->name = currentToken().value;
+ASTNode* Parser::constDef(string_view type,int line) {
+    auto constDefNode = arena->make<ConstDefNode>();
+    constDefNode->name = currentName();
     constDefNode->constdeftype = type;
     constDefNode->linenum = line;
     match(IDENFR);
     if (currentToken().type == LBRACK) {
-        constDefNode->constdeftype += "Array";
+        constDefNode->constdeftype = arrayType(type);
         match(LBRACK);
         constDefNode->arraysize = constExp();
         match(RBRACK);
     }
     match(ASSIGN);
-    constInitVal(std::move(constDefNode));
+    constInitVal(constDefNode);
     return constDefNode;
 }
 
-unique_ptr<ASTNode> Parser::constInitVal(unique_ptr<ConstDefNode> &&constDefNode) {
+ASTNode* Parser::constInitVal(ConstDefNode* constDefNode) {
     if (currentToken().type == STRCON) {
-        strcon(std::move(constDefNode));
+        strcon(constDefNode);
     } else if (currentToken().type == LBRACE) {
         match(LBRACE);
         if (currentToken().type != RBRACE) {
@@ -129,14 +150,14 @@ unique_ptr<ASTNode> Parser::constInitVal(unique_ptr<ConstDefNode> &&constDefNode
     return nullptr;
 }
 
-unique_ptr<ASTNode> Parser::varDecl() {
-    string vartype;
+ASTNode* Parser::varDecl() {
+    string_view vartype;
     if(currentToken().type == INTTK)
         vartype = "Int";
     else if(currentToken().type == CHARTK)
         vartype = "Char";
     match(currentToken().type); // INTTK or CHARTK
-    auto varDeclNode = make_unique<VarDeclNode>();
+    auto varDeclNode = arena->make<VarDeclNode>();
     varDeclNode->varDefs.push_back(varDef(vartype,currentToken().lineNumber));
     while (currentToken().type == COMMA) {
         match(COMMA);
@@ -146,28 +167,28 @@ unique_ptr<ASTNode> Parser::varDecl() {
     return varDeclNode;
 }
 
-unique_ptr<ASTNode> Parser::varDef(string type,int line) {
-    auto varDefNode = make_unique<VarDefNode>();
-    varDefNode->name = currentToken().value;
+ASTNode* Parser::varDef(string_view type,int line) {
+    auto varDefNode = arena->make<VarDefNode>();
+    varDefNode->name = currentName();
     varDefNode->vardeftype = type;
     varDefNode->linenum = line;
     match(IDENFR);
     if (currentToken().type == LBRACK) {
-        varDefNode->vardeftype += "Array";
+        varDefNode->vardeftype = arrayType(type);
         match(LBRACK);
         varDefNode->arraysize = constExp();
         match(RBRACK);
     }
     if (currentToken().type == ASSIGN) {
         match(ASSIGN);
-        initVal(std::move(varDefNode));
+        initVal(varDefNode);
     }
     return varDefNode;
 }
 
-unique_ptr<ASTNode> Parser::initVal(unique_ptr<VarDefNode> &&varDefNode) {
+ASTNode* Parser::initVal(VarDefNode* varDefNode) {
     if (currentToken().type == STRCON) {
-        strcon(std::move(varDefNode));
+        strcon(varDefNode);
     } else if (currentToken().type == LBRACE) {
         match(LBRACE);
         if (currentToken().type != RBRACE) {
@@ -185,10 +206,10 @@ unique_ptr<ASTNode> Parser::initVal(unique_ptr<VarDefNode> &&varDefNode) {
     return nullptr;
 }
 
-unique_ptr<ASTNode> Parser::funcDef(string type,int line) {
+ASTNode* Parser::funcDef(string_view type,int line) {
     match(currentToken().type); // VOIDTK, INTTK, or CHARTK
-    auto funcDefNode = make_unique<FuncDefNode>();
-    funcDefNode->name = currentToken().value;
+    auto funcDefNode = arena->make<FuncDefNode>();
+    funcDefNode->name = currentName();
     funcDefNode->funcdeftype = type;
     funcDefNode->linenum = line;
     match(IDENFR);
@@ -201,18 +222,18 @@ unique_ptr<ASTNode> Parser::funcDef(string type,int line) {
     return funcDefNode;
 }
 
-unique_ptr<ASTNode> Parser::mainFuncDef() {
+ASTNode* Parser::mainFuncDef() {
     match(INTTK);
     match(MAINTK);
     match(LPARENT);
     match(RPARENT);
-    auto mainFuncDefNode = make_unique<MainFuncDefNode>();
+    auto mainFuncDefNode = arena->make<MainFuncDefNode>();
     mainFuncDefNode->block = block(false);
     return mainFuncDefNode;
 }
 
-unique_ptr<ASTNode> Parser::funcFParams() {
-    auto funcFParamsNode = make_unique<FuncFParamsNode>();
+ASTNode* Parser::funcFParams() {
+    auto funcFParamsNode = arena->make<FuncFParamsNode>();
     funcFParamsNode->params.push_back(funcFParam());
     while (currentToken().type == COMMA) {
         match(COMMA);
@@ -221,8 +242,8 @@ unique_ptr<ASTNode> Parser::funcFParams() {
     return funcFParamsNode;
 }
 
-unique_ptr<ASTNode> Parser::funcFParam() {
-    auto funcFParamNode = make_unique<FuncFParamNode>();
+ASTNode* Parser::funcFParam() {
+    auto funcFParamNode = arena->make<FuncFParamNode>();
     funcFParamNode->type = currentToken().type; // INTTK or CHARTK
     if(currentToken().type == INTTK) {
         funcFParamNode->realtype = "Int";
@@ -230,23 +251,23 @@ unique_ptr<ASTNode> Parser::funcFParam() {
         funcFParamNode->realtype = "Char";
     }
     match(currentToken().type);
-    funcFParamNode->name = currentToken().value;
+    funcFParamNode->name = currentName();
     funcFParamNode->linenum = currentToken().lineNumber;
     match(IDENFR);
     if (currentToken().type == LBRACK) {
         match(LBRACK);
         match(RBRACK);
         funcFParamNode->isArray = true;
-        funcFParamNode->realtype += "Array";
+        funcFParamNode->realtype = arrayType(funcFParamNode->realtype);
     } else {
         funcFParamNode->isArray = false;
     }
     return funcFParamNode;
 }
 
-unique_ptr<ASTNode> Parser::block(bool blockisfor) {
+ASTNode* Parser::block(bool blockisfor) {
     match(LBRACE);
-    auto blockNode = make_unique<BlockNode>();
+    auto blockNode = arena->make<BlockNode>();
     while (currentToken().type != RBRACE) {
         if (currentToken().type == CONSTTK || currentToken().type == INTTK || currentToken().type == CHARTK) {
             blockNode->stmts.push_back(decl());
@@ -260,62 +281,62 @@ unique_ptr<ASTNode> Parser::block(bool blockisfor) {
     return blockNode;
 }
 
-unique_ptr<ASTNode> Parser::stmt(bool blockisfor) {
+ASTNode* Parser::stmt(bool blockisfor) {
     if (currentToken().type == LBRACE) {
         return block(blockisfor);
     } else if (currentToken().type == IFTK) {
         match(IFTK);
-        auto ifStmtNode = make_unique<IfStmtNode>();
+        auto ifStmtNode = arena->make<IfStmtNode>();
         match(LPARENT);
-        unique_ptr<ASTNode> realcond = cond();
+        ASTNode* realcond = cond();
         match(RPARENT);
         auto thenStmt = stmt(false);
-        unique_ptr<ASTNode> elseStmt = nullptr;
+        ASTNode* elseStmt = nullptr;
         if (currentToken().type == ELSETK) {
             match(ELSETK);
             elseStmt = stmt(false);
         }
-        ifStmtNode->ifcond = move(realcond);
-        ifStmtNode->thenStmt = move(thenStmt);
-        ifStmtNode->elseStmt = move(elseStmt);
+        ifStmtNode->ifcond = realcond;
+        ifStmtNode->thenStmt = thenStmt;
+        ifStmtNode->elseStmt = elseStmt;
         return ifStmtNode;
     } else if (currentToken().type == FORTK) {
         match(FORTK);
         match(LPARENT);
-        unique_ptr<ASTNode> init = nullptr;
+        ASTNode* init = nullptr;
         if (currentToken().type != SEMICN) {
             init = forStmt();
         }
         match(SEMICN);
-        unique_ptr<ASTNode> realcond = nullptr;
+        ASTNode* realcond = nullptr;
         if (currentToken().type != SEMICN) {
             realcond = cond();
         }
         match(SEMICN);
-        unique_ptr<ASTNode> step = nullptr;
+        ASTNode* step = nullptr;
         if (currentToken().type != RPARENT) {
             step = forStmt();
         }
         match(RPARENT);
         auto body = stmt(true);
-        auto forNode = make_unique<ForNode>();
-        forNode->init = move(init);
-        forNode->forcond = move(realcond);
-        forNode->step = move(step);
-        forNode->body = move(body);
+        auto forNode = arena->make<ForNode>();
+        forNode->init = init;
+        forNode->forcond = realcond;
+        forNode->step = step;
+        forNode->body = body;
         return forNode;
     } else if (currentToken().type == BREAKTK) {
         int linenum = currentToken().lineNumber;
         match(BREAKTK);
         match(SEMICN);
-        return make_unique<BreakStmtNode>(linenum);
+        return arena->make<BreakStmtNode>(linenum);
     } else if (currentToken().type == CONTINUETK) {
         int linenum = currentToken().lineNumber;
         match(CONTINUETK);
         match(SEMICN);
-        return make_unique<ContinueStmtNode>(linenum);
+        return arena->make<ContinueStmtNode>(linenum);
     } else if (currentToken().type == RETURNTK) {
-        auto returnStmtNode = make_unique<ReturnStmtNode>();
+        auto returnStmtNode = arena->make<ReturnStmtNode>();
         returnStmtNode->linenum = currentToken().lineNumber;
         match(RETURNTK);
         if (currentToken().type != SEMICN) {
@@ -326,8 +347,8 @@ unique_ptr<ASTNode> Parser::stmt(bool blockisfor) {
     } else if (currentToken().type == PRINTFTK) {
         match(PRINTFTK);
         match(LPARENT);
-        auto printfStmtNode = make_unique<PrintfStmtNode>();
-        printfStmtNode->format = currentToken().value;
+        auto printfStmtNode = arena->make<PrintfStmtNode>();
+        printfStmtNode->format = arena->copy(currentToken().value);
         printfStmtNode->printlinenum = currentToken().lineNumber;
         match(STRCON);
         while (currentToken().type == COMMA) {
@@ -339,9 +360,9 @@ unique_ptr<ASTNode> Parser::stmt(bool blockisfor) {
         return printfStmtNode;
     } else if (currentToken().type == SEMICN) {
         match(SEMICN);
-        return make_unique<EmptyStmtNode>();
+        return arena->make<EmptyStmtNode>();
     } else if (currentToken().type == IDENFR) {
-        if (lookAhead(1).type == LBRACK || lookAhead(1).type == ASSIGN) {
+        if (lookAheadType(1) == LBRACK || lookAheadType(1) == ASSIGN) {
             auto lValNode = lVal();
             match(ASSIGN);
             if (currentToken().type == GETINTTK) {
@@ -349,8 +370,8 @@ unique_ptr<ASTNode> Parser::stmt(bool blockisfor) {
                 match(LPARENT);
                 match(RPARENT);
                 match(SEMICN);
-                auto assignStmtNode = make_unique<AssignStmtNode>();
-                assignStmtNode->lval = move(lValNode);
+                auto assignStmtNode = arena->make<AssignStmtNode>();
+                assignStmtNode->lval = lValNode;
                 assignStmtNode->getint = true;
                 assignStmtNode->getchar = false;
                 return assignStmtNode;
@@ -359,32 +380,32 @@ unique_ptr<ASTNode> Parser::stmt(bool blockisfor) {
                 match(LPARENT);
                 match(RPARENT);
                 match(SEMICN);
-                auto assignStmtNode = make_unique<AssignStmtNode>();
-                assignStmtNode->lval = move(lValNode);
+                auto assignStmtNode = arena->make<AssignStmtNode>();
+                assignStmtNode->lval = lValNode;
                 assignStmtNode->getchar = true;
                 assignStmtNode->getint = false;
                 return assignStmtNode;
             } else {
                 auto expNode = exp();
                 match(SEMICN);
-                auto assignStmtNode = make_unique<AssignStmtNode>();
-                assignStmtNode->lval = move(lValNode);
-                assignStmtNode->exp = move(expNode);
+                auto assignStmtNode = arena->make<AssignStmtNode>();
+                assignStmtNode->lval = lValNode;
+                assignStmtNode->exp = expNode;
                 return assignStmtNode;
             }
         } else {
             /*exp在pcode中不算数*/
             auto expNode = exp();
             match(SEMICN);
-            auto expStmtNode = make_unique<ExpStmtNode>();
-            expStmtNode->exp = move(expNode);    
+            auto expStmtNode = arena->make<ExpStmtNode>();
+            expStmtNode->exp = expNode;    
             return expStmtNode;//exp
         }
     } else if (currentToken().type == INTCON || currentToken().type == CHRCON || currentToken().type == STRCON || currentToken().type == LPARENT || currentToken().type == PLUS || currentToken().type == MINU || currentToken().type == NOT) {
         /*exp在pcode中不算数*/
-        auto expNode = exp();
+        exp();
         match(SEMICN);
-        auto expStmtNode = make_unique<ExpStmtNode>();
+        auto expStmtNode = arena->make<ExpStmtNode>();
         return expStmtNode;
     } else {
         processError(currentToken().lineNumber, "Unexpected token in Stmt");
@@ -392,17 +413,17 @@ unique_ptr<ASTNode> Parser::stmt(bool blockisfor) {
     }
 }
 
-unique_ptr<ASTNode> Parser::exp() {
+ASTNode* Parser::exp() {
     return addExp();
 }
 
-unique_ptr<ASTNode> Parser::cond() {
+ASTNode* Parser::cond() {
     return loExp();
 }
 
-unique_ptr<ASTNode> Parser::lVal() {
-    auto lValNode = make_unique<LValNode>();
-    lValNode->name = currentToken().value;
+ASTNode* Parser::lVal() {
+    auto lValNode = arena->make<LValNode>();
+    lValNode->name = currentName();
     lValNode->linenum = currentToken().lineNumber;
     match(IDENFR);
     if (currentToken().type == LBRACK) {
@@ -414,7 +435,7 @@ unique_ptr<ASTNode> Parser::lVal() {
     return lValNode;
 }
 
-unique_ptr<ASTNode> Parser::primaryExp() {
+ASTNode* Parser::primaryExp() {
     if (currentToken().type == LPARENT) {
         match(LPARENT);
         auto expNode = exp();
@@ -427,23 +448,23 @@ unique_ptr<ASTNode> Parser::primaryExp() {
     } else if (currentToken().type == CHRCON) {
         return character();
     } else {
-        cout<<"UNEXPECTED "<<currentToken().type<<" "<<currentToken().value<<endl;
+        TRACE(TRACE_DETAIL, "UNEXPECTED " << currentToken().type << " " << currentToken().value);
         processError(currentToken().lineNumber, "Unexpected token in PrimaryExp");
         return nullptr;
     }
 }
 
-unique_ptr<ASTNode> Parser::unaryExp() {
+ASTNode* Parser::unaryExp() {
     if (currentToken().type == PLUS || currentToken().type == MINU || currentToken().type == NOT) {
-        auto unaryExpnode = make_unique<UnaryExpNode>();
+        auto unaryExpnode = arena->make<UnaryExpNode>();
         unaryExpnode->unaryop = currentToken().type;
         match(currentToken().type);
         unaryExpnode->unaryexp = unaryExp();
         return unaryExpnode;
-    } else if (currentToken().type == IDENFR && lookAhead(1).type == LPARENT) {
-        auto funcRParamsNode = make_unique<FuncRParamsNode>();
+    } else if (currentToken().type == IDENFR && lookAheadType(1) == LPARENT) {
+        auto funcRParamsNode = arena->make<FuncRParamsNode>();
         funcRParamsNode->linenum = currentToken().lineNumber;   //c和d和e：实参
-        funcRParamsNode->name = currentToken().value;
+        funcRParamsNode->name = currentName();
         match(IDENFR);
         match(LPARENT);
         if (currentToken().type==IDENFR||currentToken().type==INTCON||currentToken().type==CHRCON||currentToken().type==STRCON||currentToken().type==LPARENT||currentToken().type==PLUS||currentToken().type==MINU||currentToken().type==NOT) {
@@ -460,8 +481,8 @@ unique_ptr<ASTNode> Parser::unaryExp() {
     }
 }
 
-unique_ptr<ASTNode> Parser::funcRParams() { //一直没用上
-    auto funcRParamsNode = make_unique<FuncRParamsNode>();
+ASTNode* Parser::funcRParams() { //一直没用上
+    auto funcRParamsNode = arena->make<FuncRParamsNode>();
     funcRParamsNode->params.push_back(exp());
     while (currentToken().type == COMMA) {
         match(COMMA);
@@ -470,8 +491,8 @@ unique_ptr<ASTNode> Parser::funcRParams() { //一直没用上
     return funcRParamsNode;
 }
 
-unique_ptr<ASTNode> Parser::mulExp() {
-    auto mulExpNode = make_unique<MulExpNode>();
+ASTNode* Parser::mulExp() {
+    auto mulExpNode = arena->make<MulExpNode>();
     mulExpNode->operands.push_back(unaryExp());
     while (currentToken().type == MULT || currentToken().type == DIV || currentToken().type == MOD) {
         mulExpNode->operators.push_back(currentToken().type);
@@ -481,8 +502,8 @@ unique_ptr<ASTNode> Parser::mulExp() {
     return mulExpNode;
 }
 
-unique_ptr<ASTNode> Parser::addExp() {
-    auto addExpNode = make_unique<AddExpNode>();
+ASTNode* Parser::addExp() {
+    auto addExpNode = arena->make<AddExpNode>();
     addExpNode->operands.push_back(mulExp());
     while (currentToken().type == PLUS || currentToken().type == MINU) {
         addExpNode->operators.push_back(currentToken().type);
@@ -492,8 +513,8 @@ unique_ptr<ASTNode> Parser::addExp() {
     return addExpNode;
 }
 
-unique_ptr<ASTNode> Parser::reExp() {
-    auto relExpNode = make_unique<RelExpNode>();
+ASTNode* Parser::reExp() {
+    auto relExpNode = arena->make<RelExpNode>();
     relExpNode->operands.push_back(addExp());
     while (currentToken().type == LSS || currentToken().type == GRE || currentToken().type == LEQ || currentToken().type == GEQ) {
         relExpNode->operators.push_back(currentToken().type);
@@ -503,8 +524,8 @@ unique_ptr<ASTNode> Parser::reExp() {
     return relExpNode;
 }
 
-unique_ptr<ASTNode> Parser::eqExp() {
-    auto eqExpNode = make_unique<EqExpNode>();
+ASTNode* Parser::eqExp() {
+    auto eqExpNode = arena->make<EqExpNode>();
     eqExpNode->operands.push_back(reExp());
     while (currentToken().type == EQL || currentToken().type == NEQ) {
         eqExpNode->operators.push_back(currentToken().type);
@@ -514,8 +535,8 @@ unique_ptr<ASTNode> Parser::eqExp() {
     return eqExpNode;
 }
 
-unique_ptr<ASTNode> Parser::laExp() {
-    auto landExpNode = make_unique<LandExpNode>();
+ASTNode* Parser::laExp() {
+    auto landExpNode = arena->make<LandExpNode>();
     landExpNode->operands.push_back(eqExp());
     while (currentToken().type == AND) {
         landExpNode->operators.push_back(currentToken().type);
@@ -525,8 +546,8 @@ unique_ptr<ASTNode> Parser::laExp() {
     return landExpNode;
 }
 
-unique_ptr<ASTNode> Parser::loExp() {
-    auto lorExpNode = make_unique<LorExpNode>();
+ASTNode* Parser::loExp() {
+    auto lorExpNode = arena->make<LorExpNode>();
     lorExpNode->operands.push_back(laExp());
     while (currentToken().type == OR) {
         lorExpNode->operators.push_back(currentToken().type);
@@ -536,27 +557,30 @@ unique_ptr<ASTNode> Parser::loExp() {
     return lorExpNode;
 }
 
-unique_ptr<ASTNode> Parser::number() {
-    auto numberNode = make_unique<NumberNode>();
-    numberNode->value = stoi(currentToken().value);
+ASTNode* Parser::number() {
+    auto numberNode = arena->make<NumberNode>();
+    string_view digits = currentToken().value;
+    int value = 0;
+    from_chars(digits.data(), digits.data() + digits.size(), value);
+    numberNode->value = value;
     match(INTCON);
     return numberNode;
 }
 
-unique_ptr<ASTNode> Parser::character() {
-    auto characterNode = make_unique<CharacterNode>();
-    characterNode->value = currentToken().value;
+ASTNode* Parser::character() {
+    auto characterNode = arena->make<CharacterNode>();
+    characterNode->value = arena->copy(currentToken().value);
     match(CHRCON);
     return characterNode;
 }
 /*
-unique_ptr<ASTNode> Parser::str2char(char ch) {
-    auto characterNode = make_unique<CharacterNode>();
+ASTNode* Parser::str2char(char ch) {
+    auto characterNode = arena->make<CharacterNode>();
     characterNode->value = ch;
     return characterNode;
 }
 
-unique_ptr<ASTNode> Parser::strcon(unique_ptr<ConstDefNode> && constDefNode) {
+ASTNode* Parser::strcon(ConstDefNode* constDefNode) {
     for(auto thischar: currentToken().value){
         if(thischar != '"'){
             constDefNode->initVals.push_back(str2char(thischar));
@@ -566,15 +590,15 @@ unique_ptr<ASTNode> Parser::strcon(unique_ptr<ConstDefNode> && constDefNode) {
     return nullptr;
 }
 */
-unique_ptr<ASTNode> Parser::str2char(char ch) {
-    auto characterNode = make_unique<CharacterNode>();
-    characterNode->value = ch; // 直接存储字符
+ASTNode* Parser::str2char(char ch) {
+    auto characterNode = arena->make<CharacterNode>();
+    characterNode->value = arena->copy(string_view(&ch, 1)); // 直接存储字符
     return characterNode;
 }
 
 // 修改后的 strcon 函数
-unique_ptr<ASTNode> Parser::strcon(unique_ptr<ConstDefNode> &&constDefNode) {
-    std::string str = currentToken().value.substr(1, currentToken().value.length() - 2); // 去掉首尾的双引号
+ASTNode* Parser::strcon(ConstDefNode* constDefNode) {
+    std::string str(currentToken().value.substr(1, currentToken().value.length() - 2)); // 去掉首尾的双引号
 
     for (size_t i = 0; i < str.length(); ++i) {
         if (str[i] == '\\' && i + 1 < str.length() && str[i + 1] == 'n') {
@@ -594,7 +618,7 @@ unique_ptr<ASTNode> Parser::strcon(unique_ptr<ConstDefNode> &&constDefNode) {
     match(STRCON); // 匹配字符串常量
     return nullptr;
 }
-unique_ptr<ASTNode> Parser::strcon(unique_ptr<VarDefNode> && varDefNode) {
+ASTNode* Parser::strcon(VarDefNode* varDefNode) {
     for(auto thischar: currentToken().value){
         if(thischar != '"'){
             varDefNode->initVals.push_back(str2char(thischar));
@@ -604,47 +628,50 @@ unique_ptr<ASTNode> Parser::strcon(unique_ptr<VarDefNode> && varDefNode) {
     return nullptr;
 }
 
-unique_ptr<ASTNode> Parser::constExp() {
+ASTNode* Parser::constExp() {
     return addExp();
 }
 
-unique_ptr<ASTNode> Parser::forStmt() {//小for
-    auto smallforStmtNode = make_unique<SmallforstmtNode>();
+ASTNode* Parser::forStmt() {//小for
+    auto smallforStmtNode = arena->make<SmallforstmtNode>();
     auto lValNode = lVal();
     match(ASSIGN);
     auto expNode = exp();
-    smallforStmtNode->lval = move(lValNode);
-    smallforStmtNode->exp = move(expNode);
+    smallforStmtNode->lval = lValNode;
+    smallforStmtNode->exp = expNode;
     return smallforStmtNode;
 }
 
-Token Parser::currentToken() const {
-    if (currentIndex < tokens.size()) {
-        return tokens[currentIndex];
-    }
-    return {UNKNOWN, "", -1};
+const Token Parser::eofToken = {UNKNOWN, -1, ""};
+
+/*current 缓存当前单词，每次前进时从 TokenStream 取出一次；读完后停在 eofToken*/
+void Parser::advance() {
+    currentIndex++;
+    current = currentIndex < tokens.size() ? tokens[currentIndex] : eofToken;
 }
 
-Token Parser::lookAhead(int offset) const {
-    int index = currentIndex + offset;
-    if (index < tokens.size()) {
-        return tokens[index];
-    }
-    return {UNKNOWN, "", -1};
+/*标识符直接取词法分析时的编号；出错恢复时名字位置上可能是别的单词，按其文字驻留*/
+IdentId Parser::currentName() const {
+    return current.type == IDENFR ? current.id : identifiers.intern(current.value);
+}
+
+TokenType Parser::lookAheadType(int offset) const {
+    size_t index = currentIndex + offset;
+    return index < tokens.size() ? tokens.type(index) : eofToken.type;
 }
 
 void Parser::match(TokenType expectedType) {
-    if (currentToken().type == expectedType) {
-        processToken(currentToken().type, currentToken().value);
-        currentIndex++;
+    if (current.type == expectedType) {
+        processToken(current.type, current.value);
+        advance();
     } else if (expectedType == RPARENT) {
-        processError(tokens[currentIndex - 1].lineNumber, "j");
+        processError(tokens.line(currentIndex - 1), "j");
     } else if (expectedType == SEMICN) {
-        processError(tokens[currentIndex - 1].lineNumber, "i");
+        processError(tokens.line(currentIndex - 1), "i");
     } else if (expectedType == RBRACK) {
-        processError(tokens[currentIndex - 1].lineNumber, "k");
+        processError(tokens.line(currentIndex - 1), "k");
     } else {
-        processError(tokens[currentIndex - 1].lineNumber, "Expected " + tokenTypeMap[expectedType] + ", found " + tokenTypeMap[currentToken().type]);
+        processError(tokens.line(currentIndex - 1), "Expected " + string(tokenTypeMap[expectedType]) + ", found " + string(tokenTypeMap[currentToken().type]));
     }
 }
 
@@ -656,16 +683,15 @@ void printAST(ASTNode* node, int indent) {
             auto compUnitNode = static_cast<CompUnitNode*>(node);
             cout << string(indent, ' ') << "CompUnitNode" << endl;
             for (auto& decl : compUnitNode->decls) {
-                printAST(decl.get(), indent + 2);
+                printAST(decl, indent + 2);
             }
             for (auto& funcDef : compUnitNode->funcDefs) {
-                printAST(funcDef.get(), indent + 2);
+                printAST(funcDef, indent + 2);
             }
-            printAST(compUnitNode->mainFuncDef.get(), indent + 2);
+            printAST(compUnitNode->mainFuncDef, indent + 2);
             break;
         }
         case NODE_DECL: {
-            auto declNode = static_cast<DeclNode*>(node);
             cout << string(indent, ' ') << "DeclNode" << endl;
             break;
         }
@@ -673,17 +699,17 @@ void printAST(ASTNode* node, int indent) {
             auto constDeclNode = static_cast<ConstDeclNode*>(node);
             cout << string(indent, ' ') << "ConstDeclNode" << endl;
             for (auto& constDef : constDeclNode->constDefs) {
-                printAST(constDef.get(), indent + 2);
+                printAST(constDef, indent + 2);
             }
             break;
         }
         case NODE_CONSTDEF: {
             auto constDefNode = static_cast<ConstDefNode*>(node);
-            cout << string(indent, ' ') << "ConstDefNode: " << constDefNode->name << endl;
+            cout << string(indent, ' ') << "ConstDefNode: " << identifiers.name(constDefNode->name) << endl;
             if(constDefNode->arraysize)
-                printAST(constDefNode->arraysize.get(), indent + 2);
+                printAST(constDefNode->arraysize, indent + 2);
             for (auto& initval : constDefNode->initVals) {
-                printAST(initval.get(), indent + 2);
+                printAST(initval, indent + 2);
             }
             break;
         }
@@ -691,32 +717,32 @@ void printAST(ASTNode* node, int indent) {
             auto varDeclNode = static_cast<VarDeclNode*>(node);
             cout << string(indent, ' ') << "VarDeclNode" << endl;
             for (auto& varDef : varDeclNode->varDefs) {
-                printAST(varDef.get(), indent + 2);
+                printAST(varDef, indent + 2);
             }
             break;
         }
         case NODE_VARDEF: {
             auto varDefNode = static_cast<VarDefNode*>(node);
-            cout << string(indent, ' ') << "VarDefNode: " << varDefNode->name << endl;
+            cout << string(indent, ' ') << "VarDefNode: " << identifiers.name(varDefNode->name) << endl;
             if(varDefNode->arraysize)
-                printAST(varDefNode->arraysize.get(), indent + 2);
+                printAST(varDefNode->arraysize, indent + 2);
             for (auto& initval : varDefNode->initVals) {
-                printAST(initval.get(), indent + 2);
+                printAST(initval, indent + 2);
             }
             break;
         }
         case NODE_FUNCDEF: {
             auto funcDefNode = static_cast<FuncDefNode*>(node);
-            cout << string(indent, ' ') << "FuncDefNode: " << funcDefNode->name << endl;
+            cout << string(indent, ' ') << "FuncDefNode: " << identifiers.name(funcDefNode->name) << endl;
             if (funcDefNode->params) {
-                printAST(funcDefNode->params.get(), indent + 2);
+                printAST(funcDefNode->params, indent + 2);
             }
-            printAST(funcDefNode->block.get(), indent + 2);
+            printAST(funcDefNode->block, indent + 2);
             break;
         }
         case NODE_FUNCFPARAM: {
             auto funcFParamNode = static_cast<FuncFParamNode*>(node);
-            cout << string(indent, ' ') << "FuncFParamNode: " << tokenTypeMap[funcFParamNode->type] << " " << funcFParamNode->name;
+            cout << string(indent, ' ') << "FuncFParamNode: " << tokenTypeMap[funcFParamNode->type] << " " << identifiers.name(funcFParamNode->name);
             if (funcFParamNode->isArray) {
                 cout << "[]";
             }
@@ -727,54 +753,49 @@ void printAST(ASTNode* node, int indent) {
             auto funcFParamsNode = static_cast<FuncFParamsNode*>(node);
             cout << string(indent, ' ') << "FuncFParamsNode" << endl;
             for (auto& param : funcFParamsNode->params) {
-                printAST(param.get(), indent + 2);
+                printAST(param, indent + 2);
             }       
             break;
         }
         case NODE_MAINFUNCDEF: {
             auto mainFuncDefNode = static_cast<MainFuncDefNode*>(node);
             cout << string(indent, ' ') << "MainFuncDefNode" << endl;
-            printAST(mainFuncDefNode->block.get(), indent + 2);
+            printAST(mainFuncDefNode->block, indent + 2);
             break;
         }
         case NODE_BLOCK: {
             auto blockNode = static_cast<BlockNode*>(node);
             cout << string(indent, ' ') << "BlockNode" << endl;
             for (auto& stmt : blockNode->stmts) {
-                printAST(stmt.get(), indent + 2);
+                printAST(stmt, indent + 2);
             }
             break;
         }
         case NODE_STMT: {
-            auto stmtNode = static_cast<StmtNode*>(node);
             cout << string(indent, ' ') << "StmtNode" << endl;
             break;
         }
         case NODE_EXP: {
-            auto expNode = static_cast<ExpNode*>(node);
             cout << string(indent, ' ') << "ExpNode" << endl;
             break;
         }
         case NODE_CONDEXP: {
-            auto condExpNode = static_cast<CondExpNode*>(node);
             cout << string(indent, ' ') << "CondExpNode" << endl;
             break;
         }
         case NODE_LVAL: {
             auto lValNode = static_cast<LValNode*>(node);
-            cout << string(indent, ' ') << "LValNode: " << lValNode->name << endl;
+            cout << string(indent, ' ') << "LValNode: " << identifiers.name(lValNode->name) << endl;
             if(lValNode->indice){
-                printAST(lValNode->indice.get(), indent + 2 );
+                printAST(lValNode->indice, indent + 2 );
             }
             break;
         }
         case NODE_PRIMARYEXP: {
-            auto primaryExpNode = static_cast<PrimaryExpNode*>(node);
             cout << string(indent, ' ') << "PrimaryExpNode" << endl;
             break;
         }
         case NODE_UNARYEXP: {
-            auto unaryExpNode = static_cast<UnaryExpNode*>(node);
             cout << string(indent, ' ') << "UnaryExpNode" << endl;
             break;
         }
@@ -782,7 +803,7 @@ void printAST(ASTNode* node, int indent) {
             auto funcRParamsNode = static_cast<FuncRParamsNode*>(node);
             cout << string(indent, ' ') << "FuncRParamsNode" << endl;
             for (auto& param : funcRParamsNode->params) {
-                printAST(param.get(), indent + 2);
+                printAST(param, indent + 2);
             }
             break;
         }
@@ -790,7 +811,7 @@ void printAST(ASTNode* node, int indent) {
             auto mulExpNode = static_cast<MulExpNode*>(node);
             cout << string(indent, ' ') << "MulExpNode" << endl;
             for (size_t i = 0; i < mulExpNode->operands.size(); ++i) {
-                printAST(mulExpNode->operands[i].get(), indent + 2);
+                printAST(mulExpNode->operands[i], indent + 2);
                 if (i < mulExpNode->operators.size()) {
                     cout << string(indent + 2, ' ') << tokenTypeMap[mulExpNode->operators[i]] << endl;
                 }
@@ -801,7 +822,7 @@ void printAST(ASTNode* node, int indent) {
             auto addExpNode = static_cast<AddExpNode*>(node);
             cout << string(indent, ' ') << "AddExpNode" << endl;
             for (size_t i = 0; i < addExpNode->operands.size(); ++i) {
-                printAST(addExpNode->operands[i].get(), indent + 2);
+                printAST(addExpNode->operands[i], indent + 2);
                 if (i < addExpNode->operators.size()) {
                     cout << string(indent + 2, ' ') << tokenTypeMap[addExpNode->operators[i]] << endl;
                 }
@@ -812,7 +833,7 @@ void printAST(ASTNode* node, int indent) {
             auto relExpNode = static_cast<RelExpNode*>(node);
             cout << string(indent, ' ') << "RelExpNode" << endl;
             for (size_t i = 0; i < relExpNode->operands.size(); ++i) {
-                printAST(relExpNode->operands[i].get(), indent + 2);
+                printAST(relExpNode->operands[i], indent + 2);
                 if (i < relExpNode->operators.size()) {
                     cout << string(indent + 2, ' ') << tokenTypeMap[relExpNode->operators[i]] << endl;
                 }
@@ -823,7 +844,7 @@ void printAST(ASTNode* node, int indent) {
             auto eqExpNode = static_cast<EqExpNode*>(node);
             cout << string(indent, ' ') << "EqExpNode" << endl;
             for (size_t i = 0; i < eqExpNode->operands.size(); ++i) {
-                printAST(eqExpNode->operands[i].get(), indent + 2);
+                printAST(eqExpNode->operands[i], indent + 2);
                 if (i < eqExpNode->operators.size()) {
                     cout << string(indent + 2, ' ') << tokenTypeMap[eqExpNode->operators[i]] << endl;
                 }
@@ -834,7 +855,7 @@ void printAST(ASTNode* node, int indent) {
             auto landExpNode = static_cast<LandExpNode*>(node);
             cout << string(indent, ' ') << "LandExpNode" << endl;
             for (size_t i = 0; i < landExpNode->operands.size(); ++i) {
-                printAST(landExpNode->operands[i].get(), indent + 2);
+                printAST(landExpNode->operands[i], indent + 2);
                 if (i < landExpNode->operators.size()) {
                     cout << string(indent + 2, ' ') << tokenTypeMap[landExpNode->operators[i]] << endl;
                 }
@@ -845,7 +866,7 @@ void printAST(ASTNode* node, int indent) {
             auto lorExpNode = static_cast<LorExpNode*>(node);
             cout << string(indent, ' ') << "LorExpNode" << endl;
             for (size_t i = 0; i < lorExpNode->operands.size(); ++i) {
-                printAST(lorExpNode->operands[i].get(), indent + 2);
+                printAST(lorExpNode->operands[i], indent + 2);
                 if (i < lorExpNode->operators.size()) {
                     cout << string(indent + 2, ' ') << tokenTypeMap[lorExpNode->operators[i]] << endl;
                 }
@@ -863,7 +884,6 @@ void printAST(ASTNode* node, int indent) {
             break;
         }
         case NODE_CONSTEXP: {
-            auto constExpNode = static_cast<ConstExpNode*>(node);
             cout << string(indent, ' ') << "ConstExpNode" << endl;
             break;
         }
@@ -871,7 +891,7 @@ void printAST(ASTNode* node, int indent) {
             auto returnStmtNode = static_cast<ReturnStmtNode*>(node);
             cout << string(indent, ' ') << "ReturnStmtNode" << endl;
             if (returnStmtNode->exp) {
-                printAST(returnStmtNode->exp.get(), indent + 2);
+                printAST(returnStmtNode->exp, indent + 2);
             }
             break;
         }
@@ -887,7 +907,7 @@ void printAST(ASTNode* node, int indent) {
             auto printfStmtNode = static_cast<PrintfStmtNode*>(node);
             cout << string(indent, ' ') << "PrintfStmtNode: " << printfStmtNode->format << endl;
             for (auto& arg : printfStmtNode->args) {
-                printAST(arg.get(), indent + 2);
+                printAST(arg, indent + 2);
             }
             break;
         }
@@ -898,23 +918,23 @@ void printAST(ASTNode* node, int indent) {
         case NODE_ASSIGNSTMT: {
             auto assignStmtNode = static_cast<AssignStmtNode*>(node);
             cout << string(indent, ' ') << "AssignStmtNode" << endl;
-            printAST(assignStmtNode->lval.get(), indent + 2);
-            printAST(assignStmtNode->exp.get(), indent + 2);
+            printAST(assignStmtNode->lval, indent + 2);
+            printAST(assignStmtNode->exp, indent + 2);
             break;
         }
         case NODE_EXPSTMT: {
             auto expStmtNode = static_cast<ExpStmtNode*>(node);
             cout << string(indent, ' ') << "ExpStmtNode" << endl;
-            printAST(expStmtNode->exp.get(), indent + 2);
+            printAST(expStmtNode->exp, indent + 2);
             break;
         }
         case NODE_IFSTMT: {
             auto ifStmtNode = static_cast<IfStmtNode*>(node);
             cout << string(indent, ' ') << "IfStmtNode" << endl;
-            printAST(ifStmtNode->ifcond.get(), indent + 2);
-            printAST(ifStmtNode->thenStmt.get(), indent + 2);
+            printAST(ifStmtNode->ifcond, indent + 2);
+            printAST(ifStmtNode->thenStmt, indent + 2);
             if (ifStmtNode->elseStmt) {
-                printAST(ifStmtNode->elseStmt.get(), indent + 2);
+                printAST(ifStmtNode->elseStmt, indent + 2);
             }
             break;
         }
@@ -923,24 +943,24 @@ void printAST(ASTNode* node, int indent) {
             cout << string(indent, ' ') << "ForNode" << endl;
             cout <<"init"<<endl;
             if (forNode->init) {
-                printAST(forNode->init.get(), indent + 2);
+                printAST(forNode->init, indent + 2);
             }
             cout <<"forcond"<<endl;
             if (forNode->forcond) {
-                printAST(forNode->forcond.get(), indent + 2);
+                printAST(forNode->forcond, indent + 2);
             }
             cout <<"step"<<endl;
             if (forNode->step) {
-                printAST(forNode->step.get(), indent + 2);
+                printAST(forNode->step, indent + 2);
             }
             cout<<"body"<<endl;
-            printAST(forNode->body.get(), indent + 2);
+            printAST(forNode->body, indent + 2);
             break;
         }
         case NODE_SmallFor: {
             auto smallforNode = static_cast<SmallforstmtNode*>(node);
-            printAST(smallforNode->lval.get(), indent + 2);
-            printAST(smallforNode->exp.get(), indent + 2);
+            printAST(smallforNode->lval, indent + 2);
+            printAST(smallforNode->exp, indent + 2);
         }
         // 其他节点类型
     }
@@ -11,60 +11,68 @@
 using namespace std;
 
 
+/*输出文件名为空时不写对应的文件；tokens 只借用，须比 Parser 活得久*/
 class Parser {
 public:
-    Parser(const vector<Token>& tokens, const string& parserOutputFile, const string& errorOutputFile);
-    unique_ptr<ASTNode> parse();
+    Parser(const TokenStream& tokens, const string& parserOutputFile, const string& errorOutputFile);
+    SyntaxTree parse();
+    const vector<string>& getErrorLines() const { return errorLines; } //"行号 错误码"
 
 private:
-    vector<Token> tokens;
+    const TokenStream& tokens;
     string parserOutputFile;
     string errorOutputFile;
     ofstream parserOutput;
     ofstream errorOutput;
-    int currentIndex = 0;
+    vector<string> errorLines;
+    size_t currentIndex = 0;
+    Token current; //当前单词，越过末尾后为 eofToken
+    AstArena* arena = nullptr; //parse 期间为正在建的树的 arena
+    static const Token eofToken;
 
     void openFiles();
     void closeFiles();
-    void processToken(TokenType type, const string& value);
+    void processToken(TokenType type, string_view value);
     void processError(int lineNumber, const string& error);
-    unique_ptr<ASTNode> compUnit();
-    unique_ptr<ASTNode> decl();
-    unique_ptr<ASTNode> constDecl();
-    unique_ptr<ASTNode> constDef(string type,int line);
-    unique_ptr<ASTNode> constInitVal(unique_ptr<ConstDefNode> &&constDefNode);
-    unique_ptr<ASTNode> varDecl();
-    unique_ptr<ASTNode> varDef(string type,int line);
-    unique_ptr<ASTNode> initVal(unique_ptr<VarDefNode> &&varDefNode);
-    unique_ptr<ASTNode> funcDef(string type,int line);
-    unique_ptr<ASTNode> mainFuncDef();
-    unique_ptr<ASTNode> funcFParams();
-    unique_ptr<ASTNode> funcFParam();
-    unique_ptr<ASTNode> block(bool blockisfor);
-    unique_ptr<ASTNode> stmt(bool blockisfor = false);
-    unique_ptr<ASTNode> exp();
-    unique_ptr<ASTNode> cond();
-    unique_ptr<ASTNode> lVal();
-    unique_ptr<ASTNode> primaryExp();
-    unique_ptr<ASTNode> unaryExp();
-    unique_ptr<ASTNode> funcRParams();
-    unique_ptr<ASTNode> mulExp();
-    unique_ptr<ASTNode> addExp();
-    unique_ptr<ASTNode> reExp();
-    unique_ptr<ASTNode> eqExp();
-    unique_ptr<ASTNode> laExp();
-    unique_ptr<ASTNode> loExp();
-    unique_ptr<ASTNode> number();
-    unique_ptr<ASTNode> strcon(unique_ptr<ConstDefNode> && constDefNode);
-    unique_ptr<ASTNode> strcon(unique_ptr<VarDefNode> && varDefNode);
-    unique_ptr<ASTNode> str2char(char ch);
-    unique_ptr<ASTNode> character();
-    unique_ptr<ASTNode> constExp();
-    unique_ptr<ASTNode> forStmt();
+    ASTNode* compUnit();
+    ASTNode* decl();
+    ASTNode* constDecl();
+    ASTNode* constDef(string_view type,int line);
+    ASTNode* constInitVal(ConstDefNode* constDefNode);
+    ASTNode* varDecl();
+    ASTNode* varDef(string_view type,int line);
+    ASTNode* initVal(VarDefNode* varDefNode);
+    ASTNode* funcDef(string_view type,int line);
+    ASTNode* mainFuncDef();
+    ASTNode* funcFParams();
+    ASTNode* funcFParam();
+    ASTNode* block(bool blockisfor);
+    ASTNode* stmt(bool blockisfor = false);
+    ASTNode* exp();
+    ASTNode* cond();
+    ASTNode* lVal();
+    ASTNode* primaryExp();
+    ASTNode* unaryExp();
+    ASTNode* funcRParams();
+    ASTNode* mulExp();
+    ASTNode* addExp();
+    ASTNode* reExp();
+    ASTNode* eqExp();
+    ASTNode* laExp();
+    ASTNode* loExp();
+    ASTNode* number();
+    ASTNode* strcon(ConstDefNode* constDefNode);
+    ASTNode* strcon(VarDefNode* varDefNode);
+    ASTNode* str2char(char ch);
+    ASTNode* character();
+    ASTNode* constExp();
+    ASTNode* forStmt();
 
 
-    Token currentToken() const;
-    Token lookAhead(int offset) const;
+    const Token& currentToken() const { return current; }
+    TokenType lookAheadType(int offset) const;
+    IdentId currentName() const;
+    void advance();
     void match(TokenType expectedType);
 };
 
@@ -0,0 +1,148 @@
+#ifndef PCODE_H
+#define PCODE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+enum Opcode : uint8_t {
+    DEF_VAR,
+    PUSH,
+    STORE,
+    LOAD,
+    ADD,
+    SUB,
+    MUL,
+    DiV,
+    GT,
+    LT,
+    EQ,
+    JUMP_IF_FALSE,
+    JUMP,
+    JUMP_IF_FALSE_SHORT,
+    JUMP_IF_TRUE_SHORT,
+    PRINT,
+    CALL,
+    RETURN,
+    END_FUNC,
+    LOAD_PARAM,
+    POP_VAR,
+    /*补充*/
+    GETINT,
+    GETCHAR,
+    ZHENG,
+    FU,
+    FEI,
+    LABEL,
+    FUNC_DEF,
+    STORE_arraysize,
+    STORE_arrayelement,
+    LOAD_arrayelement,
+    STORE_arrayindex,
+    MoD,
+    NE,
+    GE,
+    LE,
+    AnD,
+    O_R,
+    RETURN_NuLL,
+    CFarraySize,
+    LOAD_ARRPARAM,
+    FUNCBLOCKNOW,
+    STORE_KEEP, // STORE x / LOAD x，由窥孔优化合并（peephole.h）
+    /*超级指令，由fuseSuperinstructions在加载时生成*/
+    INC_VAR,    // LOAD x / PUSH c / ADD(SUB) / STORE x
+    CMP_LT_JF,  // LT / JUMP_IF_FALSE L，下同
+    CMP_GT_JF,
+    CMP_LE_JF,
+    CMP_GE_JF,
+    CMP_EQ_JF,
+    CMP_NE_JF,
+    LOAD_IDX,   // STORE_arrayindex / LOAD_arrayelement x
+    STORE_IDX,  // STORE_arrayindex / STORE_arrayelement x -1
+    OPCODE_COUNT
+};
+
+/*
+ * 一条文本形式的指令：代码生成得到的指令表由它组成，优化在这张表上改写，
+ * 解释器加载时再编码成定长的 Instruction；P_code.txt 的每一行与它一一对应
+ * 操作数按文本中的顺序存放，PRINT 的格式串不带引号
+ */
+struct PCodeLine {
+    Opcode opcode;
+    vector<string> operands;
+};
+
+/*P_code.txt 中的操作码名，超级指令只在加载后出现，没有文本形式*/
+inline const char* opcodeName(Opcode opcode) {
+    switch (opcode) {
+        case DEF_VAR: return "DEF_VAR";
+        case PUSH: return "PUSH";
+        case STORE: return "STORE";
+        case LOAD: return "LOAD";
+        case ADD: return "ADD";
+        case SUB: return "SUB";
+        case MUL: return "MULT";
+        case DiV: return "DIV";
+        case GT: return "GT";
+        case LT: return "LT";
+        case EQ: return "EQ";
+        case JUMP_IF_FALSE: return "JUMP_IF_FALSE";
+        case JUMP: return "JUMP";
+        case JUMP_IF_FALSE_SHORT: return "JUMP_IF_FALSE_SHORT";
+        case JUMP_IF_TRUE_SHORT: return "JUMP_IF_TRUE_SHORT";
+        case PRINT: return "PRINT";
+        case CALL: return "CALL";
+        case RETURN: return "RETURN";
+        case END_FUNC: return "END_FUNC";
+        case LOAD_PARAM: return "LOAD_PARAM";
+        case POP_VAR: return "POP_VAR";
+        case GETINT: return "GETINT";
+        case GETCHAR: return "GETCHAR";
+        case ZHENG: return "ZHENG";
+        case FU: return "FU";
+        case FEI: return "FEI";
+        case LABEL: return "LABEL";
+        case FUNC_DEF: return "FUNC_DEF";
+        case STORE_arraysize: return "STORE_arraysize";
+        case STORE_arrayelement: return "STORE_arrayelement";
+        case LOAD_arrayelement: return "LOAD_arrayelement";
+        case STORE_arrayindex: return "STORE_arrayindex";
+        case MoD: return "MOD";
+        case NE: return "NE";
+        case GE: return "GE";
+        case LE: return "LE";
+        case AnD: return "AND";
+        case O_R: return "OR";
+        case RETURN_NuLL: return "RETURN_NULL";
+        case CFarraySize: return "STORE_funcf_arraysize";
+        case LOAD_ARRPARAM: return "LOAD_ARRPARAM";
+        case FUNCBLOCKNOW: return "FUNCBLOCKNOW";
+        case STORE_KEEP: return "STORE_KEEP";
+        default: return "?";
+    }
+}
+
+/*指令表写成 P_code.txt 的文本，与 parsePCode 互逆*/
+inline string formatPCode(const vector<PCodeLine>& code) {
+    string text;
+    for (const PCodeLine& line : code) {
+        text += opcodeName(line.opcode);
+        for (const string& operand : line.operands) {
+            text += ' ';
+            if (line.opcode == PRINT) {
+                text += '"';
+                text += operand;
+                text += '"';
+            } else {
+                text += operand;
+            }
+        }
+        text += '\n';
+    }
+    return text;
+}
+
+#endif // PCODE_H
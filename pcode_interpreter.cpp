@@ -1,28 +1,97 @@
 #include "pcode_interpreter.h"
+#include "trace.h"
+#include <climits>
+#include <cstdlib>
 #include <limits>
+#include <algorithm>
+#include <sstream>
 using namespace std;
 
-int funcblock_stacknum = 0;
+/*分派方式由构建选项 PCODE_THREADED_DISPATCH 决定，非 GCC/Clang 编译器退回 switch*/
+#if !defined(PCODE_THREADED_DISPATCH) || !(defined(__GNUC__) || defined(__clang__))
+#undef PCODE_THREADED_DISPATCH
+#define PCODE_THREADED_DISPATCH 0
+#endif
+
 /*处理同名数组的深度*/
 int SameArrDeep = 0;
 
-void PCodeInterpreter::run(const std::string& filename,const std::string& result) {
-    instructions = parsePCodeFile(filename);
+bool PCodeInterpreter::run(const std::string& filename,const std::string& result) {
+    load(filename);
+    return runLoaded(result);
+}
+
+bool PCodeInterpreter::run(const std::string& filename,int resultFd) {
+    load(filename);
+    return runLoaded(resultFd);
+}
+
+bool PCodeInterpreter::runLoaded(const std::string& result) {
+    if (!output.openFile(result)) {
+        cerr << "Error: Could not open " << result << endl;
+        return false;
+    }
+    if (!start()) {
+        cerr << "Error: Could not write " << result << endl;
+        return false;
+    }
+    return !aborted;
+}
+
+bool PCodeInterpreter::runLoaded(int resultFd) {
+    if (!output.openFd(resultFd)) {
+        cerr << "Error: Could not open fd " << resultFd << endl;
+        return false;
+    }
+    if (!start()) {
+        cerr << "Error: Could not write fd " << resultFd << endl;
+        return false;
+    }
+    return !aborted;
+}
+
+/*从头执行已加载的程序，结束时刷新输出；返回输出是否全部写出，执行是否中止记在aborted*/
+bool PCodeInterpreter::start() {
     programCounter = 0;
-    outputfile.open(result);
+    /*全局区在slots底部，main不经CALL进入，其帧直接接在全局区之后*/
+    slots.assign(globalSlotCount + mainFrameSize, 0);
+    arrays.assign(slots.size(), ArrayView{});
+    ownedArrays.assign(slots.size(), vector<int>());
+    arrayArgs.clear();
+    frames.assign(1, Frame{0, (size_t)globalSlotCount, 0});
+    numstack.reset(operandStackLimit);
+    aborted = false;
     execute();
-    outputfile.close();
+    return output.close();
 }
 
 
-/*文件预处理 */
-std::vector<Instruction> PCodeInterpreter::parsePCodeFile(const std::string& filename) {
-    std::vector<Instruction> instructions;
+void PCodeInterpreter::load(const std::string& filename) {
     std::ifstream file(filename);
+    vector<PCodeLine> lines = parsePCode(file);
+    assemble(lines);
+    fuseSuperinstructions();
+}
+
+void PCodeInterpreter::loadCode(const std::string& code) {
+    std::istringstream input(code);
+    vector<PCodeLine> lines = parsePCode(input);
+    assemble(lines);
+    fuseSuperinstructions();
+}
+
+void PCodeInterpreter::loadProgram(const vector<PCodeLine>& code) {
+    assemble(code);
+    fuseSuperinstructions();
+}
+
+/*文件预处理 */
+std::vector<PCodeLine> PCodeInterpreter::parsePCode(std::istream& input) {
+    std::vector<PCodeLine> instructions;
     std::string line;
 
-    while (std::getline(file, line)) {
-        Instruction instr;
+    while (std::getline(input, line)) {
+        PCodeLine instr;
         size_t pos = line.find(' ');
         std::string opcodeStr = line.substr(0, pos);
         /*识别pcode*/
@@ -110,10 +179,10 @@ std::vector<Instruction> PCodeInterpreter::parsePCodeFile(const std::string& fil
             instr.opcode = LOAD_ARRPARAM;
         } else if (opcodeStr == "FUNCBLOCKNOW") {
             instr.opcode = FUNCBLOCKNOW;
+        } else if (opcodeStr == "STORE_KEEP") {
+            instr.opcode = STORE_KEEP;
         } else {
-            cout<<"=============="<<endl;
-            cout<<opcodeStr<<endl;
-            cout<<"=============="<<endl;
+            cerr << "Error: unknown opcode " << opcodeStr << endl;
             continue; // Skip unknown opcodes
         }
 
@@ -140,479 +209,730 @@ std::vector<Instruction> PCodeInterpreter::parsePCodeFile(const std::string& fil
     return instructions;
 }
 
-/*执行操作 */
-void PCodeInterpreter::execute() {
-    while (programCounter < instructions.size()) { //跳转改pc
-        //cout<<"pc: "<<programCounter<<endl;
-        const Instruction& instr = instructions[programCounter];
-        switch (instr.opcode) {
-            case DEF_VAR: {
-                //vector<int> var = {0};
-                shared_ptr<vector<int>> var = make_shared<vector<int>>(1);
-                /*记录是int还是char*/
-                if(instr.operands[0].find("Char")!=string::npos){
-                    //cout<<instr.operands[1]<<" is char"<<endl;
-                    varischar[instr.operands[1]].push(true);
-                } else {
-                    varischar[instr.operands[1]].push(false);
-                }
-                if(instr.operands[0].find("Array")!=string::npos){
-                    varisarray[instr.operands[1]].push(true);
-                } else {
-                    varisarray[instr.operands[1]].push(false);
-                }
-                variables[instr.operands[1]].push(var);//同名压栈，修改最上层。
-                break;
-            }
-            case PUSH:  {
-                numstack.push(std::stoi(instr.operands[0]));
-                break;
-            }
-            case STORE: {
-                //vector<int>& var = variables[instr.operands[0]].top();
-                shared_ptr<vector<int>> var = variables[instr.operands[0]].top();
-                if(varischar[instr.operands[0]].top()){
-                    if(varisarray[instr.operands[0]].top() == false){
-                        (*var)[0] = numstack.top() % 128;
-                        numstack.pop();
-                    } else {
-                        /*存数组*/
-                        cout<<"char array store : ERROR INSRT"<<endl;
-                    }
-                } else{
-                    if(varisarray[instr.operands[0]].top() == false){
-                        if (var) { // 检查 shared_ptr 是否为空
-                            cout<<numstack.top()<<endl;
-                            cout<<(*var).size()<<endl;
-                            (*var)[0] = numstack.top();
-                        } else {
-                            cout << "Error: shared_ptr is null for variable " << instr.operands[0] << endl;
-                        }
-                        numstack.pop();
-                    } else {
-                        /*存数组*/
-                        cout<<"int array store: ERROR INSRT"<<endl;
-                    }
-                }
-                break;
-            }
-            case LOAD:  {
-                if(varisarray[instr.operands[0]].top() == false){
-                    cout<<instr.operands[0]<<"is not array"<<endl;
-                    shared_ptr<vector<int>> var = variables[instr.operands[0]].top();
-                    numstack.push((*var)[0]);  
-                } else {
-                    /*数组传参,加载入临时数组*/
-                    shared_ptr<vector<int>> &var = variables[instr.operands[0]].top();
-                    cout<<"load array "+instr.operands[0]<<endl;
-                    
-                    tmpintvecs.push((*var));
-                    vecsname.push(instr.operands[0]);//记录实参的名字
-                    sarray2namemap[instr.operands[0]].push(variables[instr.operands[0]].top());
-                }
-                break;
-            }
-            case ADD: {
-                int b = numstack.top(); numstack.pop();
-                int a = numstack.top(); numstack.pop();
-                numstack.push(a + b);
-                break;
-            }
-            case SUB: {
-                int b = numstack.top(); numstack.pop();
-                int a = numstack.top(); numstack.pop();
-                numstack.push(a - b);
-                break;
-            }
-            case MUL: {
-                int b = numstack.top(); numstack.pop();
-                int a = numstack.top(); numstack.pop();
-                numstack.push(a * b);
-                break;
-            }
-            case DiV: {
-                int b = numstack.top(); numstack.pop();
-                //cout<<"b is "<<b<<endl;
-                int a = numstack.top(); numstack.pop();
-                //cout<<"a is "<<a<<endl;
-                numstack.push(a / b);
-                break;
-            }
-            case MoD: {
-                int b = numstack.top(); numstack.pop();
-                int a = numstack.top(); numstack.pop();
-                numstack.push(a % b);
-                break;
-            }
-            case GT: {
-                int b = numstack.top(); numstack.pop();
-                int a = numstack.top(); numstack.pop();
-                numstack.push(a > b ? 1 : 0);
-                break;
-            }
-            case LT: {
-                int b = numstack.top(); numstack.pop();
-                int a = numstack.top(); numstack.pop();
-                numstack.push(a < b ? 1 : 0);
+/*变量引用所在的操作数位置，-1表示该指令不访问变量*/
+static int slotOperand(Opcode opcode) {
+    switch (opcode) {
+        case DEF_VAR:
+        case LOAD_PARAM:
+        case LOAD_ARRPARAM:
+            return 1;
+        case STORE:
+        case LOAD:
+        case STORE_KEEP:
+        case POP_VAR:
+        case STORE_arraysize:
+        case STORE_arrayelement:
+        case LOAD_arrayelement:
+        case CFarraySize:
+            return 0;
+        default:
+            return -1;
+    }
+}
+
+/*字符串占用的堆内存，短字符串存在对象内部时为0*/
+static size_t heapBytes(const string& str) {
+    const char* data = str.data();
+    bool inline_ = data >= reinterpret_cast<const char*>(&str) && data < reinterpret_cast<const char*>(&str + 1);
+    return inline_ ? 0 : str.capacity() + 1;
+}
+
+/*把文本指令编码成定长指令：
+  G<n>/L<n> 解析成槽位，并按 DEF_VAR 的类型给每条访问指令标上 char/数组 标志；
+  统计全局区和每个函数的帧大小；立即数预先转成整数；
+  跳转标签和CALL的函数名一次性解析成指令下标，执行时跳转为O(1)*/
+void PCodeInterpreter::assemble(const vector<PCodeLine>& lines) {
+    instructions.assign(lines.size(), Instruction{});
+    strings.clear();
+    formats.clear();
+    unordered_map<string, int> stringIds;
+    auto intern = [&](const string& str) {
+        auto it = stringIds.find(str);
+        if (it != stringIds.end()) {
+            return it->second;
+        }
+        strings.push_back(str);
+        stringIds.emplace(str, (int)strings.size() - 1);
+        return (int)strings.size() - 1;
+    };
+
+    unordered_map<string, int> labels;
+    unordered_map<string, int> funcs;
+    vector<uint8_t> globalTypes;
+    vector<uint8_t> localTypes;
+    int func = -1;
+    int scalarParams = 0;
+    int arrayParams = 0;
+    globalSlotCount = 0;
+    for (size_t i = 0; i < lines.size(); i++) {
+        const PCodeLine& line = lines[i];
+        Instruction& instr = instructions[i];
+        instr.opcode = line.opcode;
+        switch (line.opcode) {
+            case FUNC_DEF:
+                func = i;
+                scalarParams = 0;
+                arrayParams = 0;
+                localTypes.clear();
+                funcs.emplace(line.operands[0], i);
+                instr.a = intern(line.operands[0]);
+                continue;
+            case LABEL:
+                labels.emplace(line.operands[0], i);
+                instr.a = intern(line.operands[0]);
+                continue;
+            case PRINT:
+                instr.a = compileFormat(line.operands[0]);
+                continue;
+            case PUSH:
+                instr.a = stoi(line.operands[0]);
+                continue;
+            case STORE_arrayelement:
+                instr.b = stoi(line.operands[1]);
                 break;
-            }
-            case GE: {
-                int b = numstack.top(); numstack.pop();
-                int a = numstack.top(); numstack.pop();
-                numstack.push(a >= b ? 1 : 0);
+            case LOAD_PARAM:
+                scalarParams++;
+                instr.b = stoi(line.operands[0]);
                 break;
-            }
-            case LE: {
-                int b = numstack.top(); numstack.pop();
-                int a = numstack.top(); numstack.pop();
-                numstack.push(a <= b ? 1 : 0);
+            case LOAD_ARRPARAM:
+                arrayParams++;
+                instr.b = stoi(line.operands[0]);
                 break;
-            }
-            case EQ: {
-                int b = numstack.top(); numstack.pop();
-                int a = numstack.top(); numstack.pop();
-                numstack.push(a == b ? 1 : 0);
+            case FUNCBLOCKNOW:
+                instr.a = scalarParams;
+                instr.b = arrayParams;
+                continue;
+            default:
                 break;
-            }
-            case NE: {
-                int b = numstack.top(); numstack.pop();
-                int a = numstack.top(); numstack.pop();
-                numstack.push(a != b ? 1 : 0);
+        }
+        int pos = slotOperand(line.opcode);
+        if (pos < 0) {
+            continue;
+        }
+        const string& ref = line.operands[pos];
+        bool global = ref[0] == 'G';
+        int slot = stoi(ref.substr(1));
+        auto& types = global ? globalTypes : localTypes;
+        if (types.size() <= (size_t)slot) {
+            types.resize(slot + 1, 0);
+        }
+        if (line.opcode == DEF_VAR) {
+            const string& type = line.operands[0];
+            types[slot] = (type.find("Char") != string::npos ? SLOT_CHAR : 0)
+                        | (type.find("Array") != string::npos ? SLOT_ARRAY : 0);
+        }
+        instr.a = slot;
+        instr.flags = types[slot] | (global ? SLOT_GLOBAL : 0);
+        if (global) {
+            globalSlotCount = max(globalSlotCount, slot + 1);
+        } else if (func >= 0) {
+            instructions[func].b = max(instructions[func].b, slot + 1);
+        }
+    }
+
+    for (size_t i = 0; i < lines.size(); i++) {
+        const PCodeLine& line = lines[i];
+        Instruction& instr = instructions[i];
+        switch (line.opcode) {
+            case JUMP:
+            case JUMP_IF_FALSE:
+            case JUMP_IF_FALSE_SHORT:
+            case JUMP_IF_TRUE_SHORT: {
+                auto it = labels.find(line.operands[0]);
+                if (it == labels.end()) {
+                    cerr << "Error: undefined label " << line.operands[0] << endl;
+                    instr.a = -1;
+                    continue;
+                }
+                instr.a = it->second;
                 break;
             }
-            case AnD: {
-                int b = numstack.top(); numstack.pop();
-                int a = numstack.top(); numstack.pop();
-                numstack.push(a && b ? 1 : 0);
+            case CALL: {
+                auto it = funcs.find(line.operands[0]);
+                if (it == funcs.end()) {
+                    cerr << "Error: undefined function " << line.operands[0] << endl;
+                    instr.a = -1;
+                    continue;
+                }
+                instr.a = it->second + 2;
+                instr.b = instructions[it->second].b;
                 break;
             }
-            case O_R: {
-                int b = numstack.top(); numstack.pop();
-                int a = numstack.top(); numstack.pop();
-                numstack.push(a || b ? 1 : 0);
+            default:
                 break;
+        }
+    }
+    auto mainIt = funcs.find("main");
+    mainFrameSize = mainIt == funcs.end() ? 0 : instructions[mainIt->second].b;
+
+    memory.count = lines.size();
+    memory.textBytes = lines.capacity() * sizeof(PCodeLine);
+    for (const auto& line : lines) {
+        memory.textBytes += line.operands.capacity() * sizeof(string);
+        for (const auto& operand : line.operands) {
+            memory.textBytes += heapBytes(operand);
+        }
+    }
+    memory.encodedBytes = instructions.capacity() * sizeof(Instruction) + strings.capacity() * sizeof(string);
+    for (const auto& str : strings) {
+        memory.encodedBytes += heapBytes(str);
+    }
+    memory.encodedBytes += formats.capacity() * sizeof(FormatPlan);
+    for (const auto& plan : formats) {
+        memory.encodedBytes += heapBytes(plan.text) + plan.segments.capacity() * sizeof(FormatSegment);
+    }
+}
+
+/*把格式串拆成字面量段和 %d/%c 占位符段，\n 转成换行；其他 % 按字面量输出*/
+int PCodeInterpreter::compileFormat(const string& format) {
+    FormatPlan plan;
+    size_t literalStart = 0;
+    auto closeLiteral = [&]() {
+        if (plan.text.size() > literalStart) {
+            plan.segments.push_back(FormatSegment{FORMAT_LITERAL, (uint32_t)literalStart, (uint32_t)(plan.text.size() - literalStart)});
+        }
+        literalStart = plan.text.size();
+    };
+    for (size_t i = 0; i < format.size(); i++) {
+        if (format[i] == '%' && i + 1 < format.size() && (format[i + 1] == 'd' || format[i + 1] == 'c')) {
+            closeLiteral();
+            plan.segments.push_back(FormatSegment{format[i + 1] == 'd' ? FORMAT_INT : FORMAT_CHAR, 0, 0});
+            plan.argCount++;
+            i++;
+        } else if (format[i] == '\\' && i + 1 < format.size() && format[i + 1] == 'n') {
+            plan.text += '\n';
+            i++;
+        } else {
+            plan.text += format[i];
+        }
+    }
+    closeLiteral();
+    formats.push_back(move(plan));
+    return (int)formats.size() - 1;
+}
+
+static bool isJump(Opcode opcode) {
+    switch (opcode) {
+        case JUMP:
+        case JUMP_IF_FALSE:
+        case JUMP_IF_FALSE_SHORT:
+        case JUMP_IF_TRUE_SHORT:
+        case CALL:
+        case CMP_LT_JF:
+        case CMP_GT_JF:
+        case CMP_LE_JF:
+        case CMP_GE_JF:
+        case CMP_EQ_JF:
+        case CMP_NE_JF:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/*比较指令对应的 比较+JUMP_IF_FALSE 超级指令*/
+static Opcode compareJumpOpcode(Opcode opcode) {
+    switch (opcode) {
+        case LT: return CMP_LT_JF;
+        case GT: return CMP_GT_JF;
+        case LE: return CMP_LE_JF;
+        case GE: return CMP_GE_JF;
+        case EQ: return CMP_EQ_JF;
+        case NE: return CMP_NE_JF;
+        default: return OPCODE_COUNT;
+    }
+}
+
+/*超级指令融合：把生成代码中高频的指令序列合并成一条指令（序列由 pcode_ngrams 统计得出）。
+  跳转目标只能是序列的第一条，融合后重新映射所有跳转目标*/
+void PCodeInterpreter::fuseSuperinstructions() {
+    size_t n = instructions.size();
+    vector<bool> isTarget(n + 1, false);
+    for (const auto& instr : instructions) {
+        if (isJump(instr.opcode) && instr.a >= 0) {
+            isTarget[instr.a] = true;
+        }
+    }
+    // 从 i 开始的 len 条指令可以合并：都存在且中间没有跳转目标
+    auto fusible = [&](size_t i, size_t len) {
+        if (i + len > n) {
+            return false;
+        }
+        for (size_t k = 1; k < len; k++) {
+            if (isTarget[i + k]) {
+                return false;
             }
-            case JUMP_IF_FALSE: {
-                int condition = numstack.top(); numstack.pop();
+        }
+        return true;
+    };
+
+    vector<Instruction> fused;
+    vector<int> newIndex(n + 1);
+    for (size_t i = 0; i < n;) {
+        const Instruction* in = &instructions[i];
+        Instruction f = *in;
+        size_t len = 1;
+        if (in[0].opcode == LOAD && !(in[0].flags & SLOT_ARRAY) && fusible(i, 4)
+            && in[1].opcode == PUSH && (in[2].opcode == ADD || (in[2].opcode == SUB && in[1].a != INT_MIN)) //-INT_MIN 溢出
+            && in[3].opcode == STORE && in[3].a == in[0].a && in[3].flags == in[0].flags) {
+            f = Instruction{INC_VAR, in[0].flags, in[0].a, in[2].opcode == ADD ? in[1].a : -in[1].a};
+            len = 4;
+        } else if (compareJumpOpcode(in[0].opcode) != OPCODE_COUNT && fusible(i, 2)
+                   && in[1].opcode == JUMP_IF_FALSE) {
+            f = Instruction{compareJumpOpcode(in[0].opcode), 0, in[1].a, 0};
+            len = 2;
+        } else if (in[0].opcode == STORE_arrayindex && fusible(i, 2)
+                   && in[1].opcode == LOAD_arrayelement) {
+            f = Instruction{LOAD_IDX, in[1].flags, in[1].a, 0};
+            len = 2;
+        } else if (in[0].opcode == STORE_arrayindex && fusible(i, 2)
+                   && in[1].opcode == STORE_arrayelement && in[1].b == -1) {
+            f = Instruction{STORE_IDX, in[1].flags, in[1].a, 0};
+            len = 2;
+        }
+        for (size_t k = 0; k < len; k++) {
+            newIndex[i + k] = fused.size();
+        }
+        fused.push_back(f);
+        i += len;
+    }
+    newIndex[n] = fused.size();
+    for (auto& instr : fused) {
+        if (isJump(instr.opcode) && instr.a >= 0) {
+            instr.a = newIndex[instr.a];
+        }
+    }
+    instructions.swap(fused);
+}
+
+/*
+ * 执行操作
+ * 两种分派方式共用同一套处理代码：
+ *   PCODE_THREADED_DISPATCH=1：GCC/Clang 的 labels-as-values，每条指令处理完直接跳到下一条的处理代码
+ *   否则：循环 + switch，可移植
+ * OP(x) 是指令x的入口，NEXT 顺序执行下一条，DISPATCH 执行 programCounter 处的指令（跳转后使用）
+ */
+void PCodeInterpreter::execute() {
+    const Instruction* instr;
+/*使栈净增长的指令压栈前检查容量，溢出时报错并停止执行*/
+#define CHECK_OVERFLOW do { \
+        if (numstack.full()) { \
+            cerr << "Error: operand stack overflow (limit " << operandStackLimit << ")" << endl; \
+            aborted = true; \
+            return; \
+        } \
+    } while (0)
+#if PCODE_THREADED_DISPATCH
+    static const void* const dispatchTable[] = {
+        &&L_DEF_VAR, &&L_PUSH, &&L_STORE, &&L_LOAD, &&L_ADD, &&L_SUB, &&L_MUL, &&L_DiV, &&L_GT,
+        &&L_LT, &&L_EQ, &&L_JUMP_IF_FALSE, &&L_JUMP, &&L_JUMP_IF_FALSE_SHORT,
+        &&L_JUMP_IF_TRUE_SHORT, &&L_PRINT, &&L_CALL, &&L_RETURN, &&L_END_FUNC, &&L_LOAD_PARAM,
+        &&L_POP_VAR, &&L_GETINT, &&L_GETCHAR, &&L_ZHENG, &&L_FU, &&L_FEI, &&L_LABEL, &&L_FUNC_DEF,
+        &&L_STORE_arraysize, &&L_STORE_arrayelement, &&L_LOAD_arrayelement, &&L_STORE_arrayindex,
+        &&L_MoD, &&L_NE, &&L_GE, &&L_LE, &&L_AnD, &&L_O_R, &&L_RETURN_NuLL, &&L_CFarraySize,
+        &&L_LOAD_ARRPARAM, &&L_FUNCBLOCKNOW, &&L_STORE_KEEP,
+        &&L_INC_VAR, &&L_CMP_LT_JF, &&L_CMP_GT_JF, &&L_CMP_LE_JF, &&L_CMP_GE_JF, &&L_CMP_EQ_JF,
+        &&L_CMP_NE_JF, &&L_LOAD_IDX, &&L_STORE_IDX
+    };
+    static_assert(sizeof(dispatchTable) / sizeof(dispatchTable[0]) == OPCODE_COUNT, "dispatch table out of sync with Opcode");
+#define OP(x) L_##x:
+#define DISPATCH do { \
+        if (programCounter >= instructions.size()) return; \
+        instr = &instructions[programCounter]; \
+        TRACE(TRACE_DETAIL, "pc " << programCounter << " op " << (int)instr->opcode); \
+        goto *dispatchTable[instr->opcode]; \
+    } while (0)
+#define NEXT do { programCounter++; DISPATCH; } while (0)
+    DISPATCH;
+    {
+#else
+#define OP(x) case x:
+#define DISPATCH continue
+#define NEXT { programCounter++; continue; }
+    while (programCounter < instructions.size()) { //跳转改pc
+        instr = &instructions[programCounter];
+        TRACE(TRACE_DETAIL, "pc " << programCounter << " op " << (int)instr->opcode);
+        switch (instr->opcode) {
+#endif
+            OP(DEF_VAR) {
+                size_t i = slotIndex(*instr);
+                slots[i] = 0;
+                arrays[i] = ArrayView{}; //数组在STORE_arraysize分配，或由LOAD_ARRPARAM绑定实参
+                NEXT;
+            }
+            OP(PUSH)  {
+                CHECK_OVERFLOW;
+                numstack.push(instr->a);
+                NEXT;
+            }
+            OP(STORE) {
+                size_t i = slotIndex(*instr);
+                if((instr->flags & SLOT_ARRAY)){
+                    /*存数组*/
+                    cerr<<((instr->flags & SLOT_CHAR) ? "char array store : ERROR INSRT" : "int array store: ERROR INSRT")<<endl;
+                } else if((instr->flags & SLOT_CHAR)){
+                    slots[i] = numstack.pop() % 128;
+                } else{
+                    TRACE(TRACE_DETAIL, "store " << numstack.top());
+                    slots[i] = numstack.pop();
+                }
+                NEXT;
+            }
+            OP(STORE_KEEP) {
+                /*存入变量，栈顶换成存入后的值，与 STORE x / LOAD x 相同*/
+                size_t i = slotIndex(*instr);
+                int& value = numstack.top();
+                slots[i] = (instr->flags & SLOT_CHAR) ? value % 128 : value;
+                value = slots[i];
+                NEXT;
+            }
+            OP(LOAD)  {
+                size_t i = slotIndex(*instr);
+                if(!(instr->flags & SLOT_ARRAY)){
+                    CHECK_OVERFLOW;
+                    numstack.push(slots[i]);
+                } else {
+                    /*数组传参，只压入实参的视图*/
+                    TRACE(TRACE_DETAIL, "load array " << instr->a);
+                    arrayArgs.push_back(arrays[i]);
+                }
+                NEXT;
+            }
+            OP(ADD) {
+                int b = numstack.pop();
+                int& a = numstack.top();
+                a = a + b;
+                NEXT;
+            }
+            OP(SUB) {
+                int b = numstack.pop();
+                int& a = numstack.top();
+                a = a - b;
+                NEXT;
+            }
+            OP(MUL) {
+                int b = numstack.pop();
+                int& a = numstack.top();
+                a = a * b;
+                NEXT;
+            }
+            OP(DiV) {
+                int b = numstack.pop();
+                int& a = numstack.top();
+                a = a / b;
+                NEXT;
+            }
+            OP(MoD) {
+                int b = numstack.pop();
+                int& a = numstack.top();
+                a = a % b;
+                NEXT;
+            }
+            OP(GT) {
+                int b = numstack.pop();
+                int& a = numstack.top();
+                a = a > b ? 1 : 0;
+                NEXT;
+            }
+            OP(LT) {
+                int b = numstack.pop();
+                int& a = numstack.top();
+                a = a < b ? 1 : 0;
+                NEXT;
+            }
+            OP(GE) {
+                int b = numstack.pop();
+                int& a = numstack.top();
+                a = a >= b ? 1 : 0;
+                NEXT;
+            }
+            OP(LE) {
+                int b = numstack.pop();
+                int& a = numstack.top();
+                a = a <= b ? 1 : 0;
+                NEXT;
+            }
+            OP(EQ) {
+                int b = numstack.pop();
+                int& a = numstack.top();
+                a = a == b ? 1 : 0;
+                NEXT;
+            }
+            OP(NE) {
+                int b = numstack.pop();
+                int& a = numstack.top();
+                a = a != b ? 1 : 0;
+                NEXT;
+            }
+            OP(AnD) {
+                int b = numstack.pop();
+                int& a = numstack.top();
+                a = a && b ? 1 : 0;
+                NEXT;
+            }
+            OP(O_R) {
+                int b = numstack.pop();
+                int& a = numstack.top();
+                a = a || b ? 1 : 0;
+                NEXT;
+            }
+            OP(JUMP_IF_FALSE) {
+                int condition = numstack.pop();
                 if (condition == 0) {
-                    for(int i=0;i<instructions.size();i++){
-                        if(instructions[i].opcode == LABEL && instructions[i].operands[0]==instr.operands[0]){
-                            programCounter = i;
-                            break;
-                        }
-                    }
-                    continue;
+                    programCounter = instr->a;
+                    DISPATCH;
                 }
-                break;
+                NEXT;
             }
-            case JUMP_IF_FALSE_SHORT: {
+            OP(JUMP_IF_FALSE_SHORT) {
                 int condition = numstack.top(); 
                 if (condition == 0) {
-                    cout<<"and跳"<<endl;
-                    for(int i=0;i<instructions.size();i++){
-                        if(instructions[i].opcode == LABEL && instructions[i].operands[0]==instr.operands[0]){
-                            programCounter = i;
-                            break;
-                        }
-                    }
-                    continue;
+                    TRACE(TRACE_DETAIL, "and跳");
+                    programCounter = instr->a;
+                    DISPATCH;
                 }
-                break;
+                NEXT;
             }
-            case JUMP_IF_TRUE_SHORT: {
+            OP(JUMP_IF_TRUE_SHORT) {
                 int condition = numstack.top(); 
                 if (condition == 1) {
-                    cout<<"or跳"<<endl;
-                    for(int i=0;i<instructions.size();i++){
-                        if(instructions[i].opcode == LABEL && instructions[i].operands[0]==instr.operands[0]){
-                            programCounter = i;
-                            break;
-                        }
-                    }
-                    continue;
-                }
-                break;
-            }
-            case JUMP:  {
-                for(int i=0;i<instructions.size();i++){
-                    if(instructions[i].opcode != LABEL)
-                        continue;
-                    if(instructions[i].operands[0]==instr.operands[0]){
-                        programCounter = i;
-                    }
-                }
-                continue;
-            }
-            case PRINT: {
-                string format = instr.operands[0];
-                size_t pos = 0;
-                int placeholderCount = 0;
-                // 统计占位符数量
-                while ((pos = format.find("%", pos)) != string::npos) {
-                    if (format[pos + 1] == 'd' || format[pos + 1] == 'c') {
-                        placeholderCount++;
-                    }
-                    pos += 2;
-                }
-                // 从栈中弹出相应数量的元素
-                std::vector<int> args;
-                for (int i = 0; i < placeholderCount; ++i) {
-                    args.push_back(numstack.top());
-                    numstack.pop();
+                    TRACE(TRACE_DETAIL, "or跳");
+                    programCounter = instr->a;
+                    DISPATCH;
                 }
-                // 从后往前替换格式化字符串中的占位符
-                pos = 0;
-                for (auto it = args.rbegin(); it != args.rend(); ++it) {
-                    if ((pos = format.find("%", pos)) != string::npos) {
-                        if (format[pos + 1] == 'd'){
-                            format.replace(pos, 2, to_string(*it));
-                        } else if(format[pos + 1] == 'c'){
-                            format.replace(pos, 2, string(1, static_cast<char>(*it)));
-                        }
+                NEXT;
+            }
+            OP(JUMP)  {
+                programCounter = instr->a;
+                DISPATCH;
+            }
+            OP(PRINT) {
+                /*按格式计划直接写进输出缓冲，第一个占位符对应最先压栈的实参*/
+                const FormatPlan& plan = formats[instr->a];
+                size_t arg = plan.argCount;
+                for (const FormatSegment& segment : plan.segments) {
+                    switch (segment.kind) {
+                        case FORMAT_LITERAL:
+                            output.write(plan.text.data() + segment.offset, segment.length);
+                            break;
+                        case FORMAT_INT:
+                            output.putInt(numstack.fromTop(--arg));
+                            break;
+                        case FORMAT_CHAR:
+                            output.put(static_cast<char>(numstack.fromTop(--arg)));
+                            break;
                     }
                 }
-                while ((pos = format.find("\\n")) != string::npos) {
-                    format.replace(pos, 2, "\n");
-                }
-                    // 如果没有换行符，直接输出
-                outputfile << format;
-                break;
-            }
-            case CALL:  {
-                callStack.push(programCounter);
-                //cout<<"call is "<<callStack.top()<<endl;
-                programCounter = functable[instr.operands[0]];
-                //cout<<"来到第"<<programCounter+1<<"行"<<endl;
-                /*做标记*/
-                //stackelenum_call = numstack.size();
-                continue;
+                numstack.drop(plan.argCount);
+                NEXT;
+            }
+            OP(CALL)  {
+                /*压入新帧，形参和局部变量的槽位清零*/
+                size_t base = slots.size();
+                frames.push_back(Frame{programCounter, base, numstack.size()});
+                slots.resize(base + instr->b, 0);
+                arrays.resize(slots.size());
+                ownedArrays.resize(slots.size());
+                programCounter = instr->a;
+                DISPATCH;
             } 
-            case FUNCBLOCKNOW: {
-                cout<<"FUNCBLOCKNOW"<<endl;
-                cout<<"and stack size is "<<numstack.size()<<endl;
-                funcblock_stacknum = numstack.size();
-                break;
-            }
-            case RETURN: {
+            OP(FUNCBLOCKNOW) {
+                /*实参已由LOAD_PARAM/LOAD_ARRPARAM按下标取走，整体退栈*/
+                numstack.drop(instr->a);
+                arrayArgs.resize(arrayArgs.size() - instr->b);
+                TRACE(TRACE_DETAIL, "FUNCBLOCKNOW stack size " << numstack.size());
+                frames.back().stackMark = numstack.size();
+                NEXT;
+            }
+            OP(RETURN) {
                 //cout<<"RETURN"<<endl;
-                int returnValue = numstack.top();
-                numstack.pop();
+                int returnValue = numstack.pop();
 
-                cout<<"stack size "<<numstack.size()<<endl;
-                int n = numstack.size() - funcblock_stacknum;
-                if(n<0){
-                    cout<<"ERROR: STACK SIZE < 0 "<<endl;
+                TRACE(TRACE_DETAIL, "return, stack size " << numstack.size());
+                if(numstack.size() < frames.back().stackMark){
+                    cerr<<"ERROR: STACK SIZE < 0 "<<endl;
                 }
                 else{
-                    while (n--)
-                    {
-                        numstack.pop();
-                    }
-                    
+                    numstack.dropTo(frames.back().stackMark);
                 }
                 numstack.push(returnValue);
                 
-                if (!callStack.empty()) {
-                    programCounter = callStack.top();
-                    //cout<<"下一次pc:"<<programCounter+1<<endl;
-                    callStack.pop();
-                } else {
-                    //cout<<"callstack is empty"<<endl;
+                if (frames.size() > 1) {
+                    returnFromCall();
                 }
-                break;
+                NEXT;
             }
-            case RETURN_NuLL: {
-                cout<<"stack size "<<numstack.size()<<endl;
-                int n = numstack.size() - funcblock_stacknum;
-                if(n<0){
-                    cout<<"ERROR: STACK SIZE < 0 "<<endl;
+            OP(RETURN_NuLL) {
+                TRACE(TRACE_DETAIL, "return, stack size " << numstack.size());
+                if(numstack.size() < frames.back().stackMark){
+                    cerr<<"ERROR: STACK SIZE < 0 "<<endl;
                 }
                 else{
-                    while (n--)
-                    {
-                        numstack.pop();
-                    }
+                    numstack.dropTo(frames.back().stackMark);
                 }
-                if (!callStack.empty()) {
-                    programCounter = callStack.top();
-                    //cout<<"回到第"<<programCounter+1<<"行"<<endl;
-                    callStack.pop();
+                if (frames.size() > 1) {
+                    returnFromCall();
                 } 
-                break;
+                NEXT;
             }
-            case END_FUNC:  {
-                if (!callStack.empty()) {
-                    programCounter = callStack.top();
-                    //cout<<"回到第"<<programCounter+1<<"行"<<endl;
-                    callStack.pop();
+            OP(END_FUNC)  {
+                if (frames.size() > 1) {
+                    returnFromCall();
                 } 
-                break;
+                NEXT;
             }
-            case LOAD_PARAM:    {
-                /**/
-                //vector<int>& var = variables[instr.operands[1]].top();
-                shared_ptr<vector<int>>& var = variables[instr.operands[1]].top();
-                if(varisarray[instr.operands[1]].top() == false){
-                    int n = stoi(instr.operands[0]);
-                    stack<int> tempStack;
-                    for (int i = 0; i < n; ++i) {
-                        tempStack.push(numstack.top());
-                        numstack.pop();
-                    }
-                    // 目标元素
-                    int targetElement = numstack.top();
-                    numstack.pop();
-                    // 将临时栈中的元素依次弹出并压回原栈
-                    while (!tempStack.empty()) {
-                        numstack.push(tempStack.top());
-                        tempStack.pop();
-                    }
-                    (*var)[0] = targetElement;
+            OP(LOAD_PARAM)    {
+                if(!(instr->flags & SLOT_ARRAY)){
+                    /*实参按下标读取，留在栈上，到FUNCBLOCKNOW一并退栈*/
+                    slots[slotIndex(*instr)] = numstack.fromTop(instr->b);
                 }else{
-                    cout<<"ERR,arr is defined var"<<endl;
+                    cerr<<"ERR,arr is defined var"<<endl;
                 }
-                break;
+                NEXT;
             }
-            case LOAD_ARRPARAM:    {
-                /*标*/
-                //vector<int>& var = variables[instr.operands[1]].top();
-                shared_ptr<vector<int>>& var = variables[instr.operands[1]].top();
-                if(varisarray[instr.operands[1]].top() == false){
-                    cout<<"ERR,var is defined arr"<<endl;
+            OP(LOAD_ARRPARAM)    {
+                if(!(instr->flags & SLOT_ARRAY)){
+                    cerr<<"ERR,var is defined arr"<<endl;
                 }else{
-                    int n = stoi(instr.operands[0]);
-                    //cout<<"装入数组"<<instr.operands[1]<<endl;
-                    //cout<<"n is "<<n<<endl;
-                    stack<vector<int>> tmparray;
-                    for(int i = 0;i<n;i++){
-                        if(!tmpintvecs.empty()){
-                            tmparray.push(tmpintvecs.top());
-                            tmpintvecs.pop();
-                        }
-                    }
-                    (*var) = tmpintvecs.top();//要赋值的真正的数组？已经赋值？*tmpintvecs是实参
-                    tmpintvecs.pop();
-                    while(!tmparray.empty()){
-                        tmpintvecs.push(tmparray.top());
-                        tmparray.pop();
-                    }
-                    /*找数组的形参实参对应关系*/
-                    stack<string> tmpname;
-                    for(int i=0;i<n;i++){
-                        tmpname.push(vecsname.top());
-                        vecsname.pop();
-                    }
-                    string shicanname=vecsname.top();
-                    vecsname.pop();
-                    while(!tmpname.empty()){
-                        vecsname.push(tmpname.top());
-                        tmpname.pop();
-                    }
-                    shared_ptr<vector<int>> real_arr_ptr = sarray2namemap[shicanname].top();
-                    var = real_arr_ptr;
-                    xarray2namemap[instr.operands[1]].push(real_arr_ptr);
-                    cout<<"形参："<<instr.operands[1]<<" 实参："<<shicanname<<endl;
+                    /*形参直接绑定实参数组的视图，从栈顶往下第n个*/
+                    arrays[slotIndex(*instr)] = arrayArgs[arrayArgs.size() - 1 - instr->b];
                 }
-                break;
-            }
-            case POP_VAR:   {
-                variables[instr.operands[0]].pop();
-                varischar[instr.operands[0]].pop();
-                varisarray[instr.operands[0]].pop();
-                if(!sarray2namemap[instr.operands[0]].empty()){
-                    sarray2namemap[instr.operands[0]].pop();
-                }
-                if(!xarray2namemap[instr.operands[0]].empty()){
-                    xarray2namemap[instr.operands[0]].pop();
+                NEXT;
+            }
+            OP(POP_VAR)   {
+                if((instr->flags & SLOT_ARRAY)){
+                    /*块结束，释放块内数组*/
+                    size_t i = slotIndex(*instr);
+                    arrays[i] = ArrayView{};
+                    vector<int>().swap(ownedArrays[i]);
                 }
-                break;
+                NEXT;
             }   /*补充*/
-            case GETINT: {
+            OP(GETINT) {
                 std::string line;
                 std::getline(std::cin, line); // 读取一整行输入
                 int value = std::stoi(line);  // 将字符串转换为整数
+                CHECK_OVERFLOW;
                 numstack.push(value);
-                break;
+                NEXT;
             }
-            case GETCHAR: {
+            OP(GETCHAR) {
                 char value;
-                cout << "getchar" << endl;
                 value = getchar(); // 使用 getchar() 读取一个字符，包括空格和换行符
-                cout << "getchar is " << value << endl;
+                TRACE(TRACE_DETAIL, "getchar is " << value);
+                CHECK_OVERFLOW;
                 numstack.push(static_cast<int>(value) & 0xFF); // 截取低8位
-                break;
+                NEXT;
             }
-            case ZHENG:  {
-                break;
+            OP(ZHENG)  {
+                NEXT;
             }
-            case FU:  {
-                int value = numstack.top();
-                numstack.pop();
-                numstack.push(-value);
-                break;
+            OP(FU)  {
+                numstack.top() = -numstack.top();
+                NEXT;
             }
-            case FEI:  {
-                int value = numstack.top();
-                numstack.pop();
-                numstack.push(!value);
-                break;
+            OP(FEI)  {
+                numstack.top() = !numstack.top();
+                NEXT;
             }
-            case LABEL:  {
-                break;
+            OP(LABEL)  {
+                NEXT;
             }
-            case FUNC_DEF:  {
-                functable[instr.operands[0]] = programCounter + 2;
-                break;
+            OP(FUNC_DEF)  {
+                /*函数入口已在linkLabels中解析*/
+                NEXT;
             }
-            case STORE_arraysize:  {
-                arraysize = numstack.top();
-                numstack.pop();
-                shared_ptr<vector<int>>& var = variables[instr.operands[0]].top();
-                (*var).resize(arraysize);
-                for(auto& it: (*var)){
-                    it = 0;
-                }
-                break;
+            OP(STORE_arraysize)  {
+                arraysize = numstack.pop();
+                size_t i = slotIndex(*instr);
+                ownedArrays[i].assign(arraysize, 0);
+                arrays[i] = ArrayView{ownedArrays[i].data(), ownedArrays[i].size()};
+                NEXT;
             }
-            case CFarraySize:  {
+            OP(CFarraySize)  {
                 /**/
-                break;
+                NEXT;
             }
-            case STORE_arrayindex:  {
-                arrayindex = numstack.top();
-                numstack.pop();
-                break;
+            OP(STORE_arrayindex)  {
+                arrayindex = numstack.pop();
+                NEXT;
             }
-            case STORE_arrayelement:  { /*参数数组的改*/
-                shared_ptr<vector<int>>& var = variables[instr.operands[0]].top();
-                int idx = stoi(instr.operands[1]);
+            OP(STORE_arrayelement)  { /*参数数组的改*/
+                int* arr = arrays[slotIndex(*instr)].data;
+                int idx = instr->b;
                 if(idx == -1){
                     idx = arrayindex;
                     arrayindex = 0;
                 }
-                if(varischar[instr.operands[0]].top()){
-                    (*var)[idx] = numstack.top() % 128;
+                if((instr->flags & SLOT_CHAR)){
+                    arr[idx] = numstack.pop() % 128;
                 } else{
-                    (*var)[idx] = numstack.top();
+                    arr[idx] = numstack.pop();
                 }
-                cout<<"store_arrayelement is "<<(*var)[idx]<<endl;
-                numstack.pop();
-                break;
+                TRACE(TRACE_DETAIL, "store_arrayelement is " << arr[idx]);
+                NEXT;
             }
-            case LOAD_arrayelement:  {
+            OP(LOAD_arrayelement)  {
                 /*也应该从数组里加载 */
-                cout<<"load arrayelement"<<endl;
-                shared_ptr<vector<int>>& var = variables[instr.operands[0]].top();
-                cout<<arrayindex<<endl;
-                cout<<(*var).size()<<endl;
-                cout<<"取"<<instr.operands[0]<<"["<<arrayindex<<"]"<<" is "<<endl;
-                for(auto it:(*var)){
-                    cout<<it<<endl;
-                }
-                numstack.push((*var)[arrayindex]);
-                break;
-            }
+                const ArrayView& arr = arrays[slotIndex(*instr)];
+                TRACE(TRACE_DETAIL, "取" << instr->a << "[" << arrayindex << "] is " << arr.data[arrayindex]);
+                CHECK_OVERFLOW;
+                numstack.push(arr.data[arrayindex]);
+                NEXT;
+            }
+            OP(INC_VAR)  {
+                size_t i = slotIndex(*instr);
+                int value = slots[i] + instr->b;
+                slots[i] = (instr->flags & SLOT_CHAR) ? value % 128 : value;
+                NEXT;
+            }
+#define COMPARE_JUMP(op, cmp) \
+            OP(op)  { \
+                int b = numstack.pop(); \
+                int a = numstack.pop(); \
+                if (!(a cmp b)) { \
+                    programCounter = instr->a; \
+                    DISPATCH; \
+                } \
+                NEXT; \
+            }
+            COMPARE_JUMP(CMP_LT_JF, <)
+            COMPARE_JUMP(CMP_GT_JF, >)
+            COMPARE_JUMP(CMP_LE_JF, <=)
+            COMPARE_JUMP(CMP_GE_JF, >=)
+            COMPARE_JUMP(CMP_EQ_JF, ==)
+            COMPARE_JUMP(CMP_NE_JF, !=)
+#undef COMPARE_JUMP
+            OP(LOAD_IDX)  {
+                arrayindex = numstack.top();
+                numstack.top() = arrays[slotIndex(*instr)].data[arrayindex];
+                NEXT;
+            }
+            OP(STORE_IDX)  {
+                int idx = numstack.pop();
+                int value = numstack.pop();
+                arrays[slotIndex(*instr)].data[idx] = (instr->flags & SLOT_CHAR) ? value % 128 : value;
+                arrayindex = 0;
+                NEXT;
+            }
+#if !PCODE_THREADED_DISPATCH
+            case OPCODE_COUNT: //只用于计数，不会出现在指令表里
+                abort();
         }
-        programCounter++;
+#endif
     }
-}
\ No newline at end of file
+#undef OP
+#undef DISPATCH
+#undef NEXT
+#undef CHECK_OVERFLOW
+}
+
+/*弹出当前帧并回到调用点*/
+void PCodeInterpreter::returnFromCall() {
+    Frame frame = frames.back();
+    frames.pop_back();
+    slots.resize(frame.base);
+    arrays.resize(frame.base);
+    ownedArrays.resize(frame.base);
+    programCounter = frame.returnAddress;
+}
@@ -10,87 +10,159 @@
 #include <fstream>
 #include <string>
 #include <memory>
+#include <cstdint>
+#include "output_sink.h"
+#include "pcode.h"
 using namespace std;
 
-enum Opcode {
-    DEF_VAR,
-    PUSH,
-    STORE,
-    LOAD,
-    ADD,
-    SUB,
-    MUL,
-    DiV,
-    GT,
-    LT,
-    EQ,
-    JUMP_IF_FALSE,
-    JUMP,
-    JUMP_IF_FALSE_SHORT,
-    JUMP_IF_TRUE_SHORT,
-    PRINT,
-    CALL,
-    RETURN,
-    END_FUNC,
-    LOAD_PARAM,
-    POP_VAR,
-    /*补充*/
-    GETINT,
-    GETCHAR,
-    ZHENG,
-    FU,
-    FEI,
-    LABEL,
-    FUNC_DEF,
-    STORE_arraysize,
-    STORE_arrayelement,
-    LOAD_arrayelement,
-    STORE_arrayindex,
-    MoD,
-    NE,
-    GE,
-    LE,
-    AnD,
-    O_R,
-    RETURN_NuLL,
-    CFarraySize,
-    LOAD_ARRPARAM,
-    FUNCBLOCKNOW
+/*变量访问指令的标志位*/
+enum SlotFlag : uint8_t {
+    SLOT_GLOBAL = 1,
+    SLOT_CHAR = 2,
+    SLOT_ARRAY = 4,
 };
 
+/*定长的已解码指令，执行时不再解析字符串
+  a/b 的含义随操作码而定：
+  PUSH                        a=立即数
+  变量访问(LOAD/STORE等)       a=槽位，flags=SlotFlag
+  STORE_arrayelement          a=槽位，b=下标(-1取arrayindex)
+  LOAD_PARAM/LOAD_ARRPARAM    a=槽位，b=实参在栈中的深度
+  FUNCBLOCKNOW                a=标量形参个数，b=数组形参个数，进入函数体时一并退栈
+  JUMP系列                    a=目标指令下标
+  CALL                        a=函数入口，b=帧大小
+  FUNC_DEF                    a=函数名在字符串池中的下标，b=帧大小
+  LABEL                       a=标签名在字符串池中的下标
+  PRINT                       a=格式计划在formats中的下标
+  INC_VAR                     a=槽位，b=增量
+  CMP_xx_JF                   a=目标指令下标
+  LOAD_IDX/STORE_IDX          a=槽位*/
 struct Instruction {
     Opcode opcode;
-    vector<string> operands;
-    int index; //数组相关
+    uint8_t flags;
+    int32_t a;
+    int32_t b;
+};
+
+/*数组的指针/长度视图：数组实参和形参只传视图，不复制元素
+  存储归定义它的槽位所有(ownedArrays)，调用者的帧总比被调函数活得久*/
+struct ArrayView {
+    int* data = nullptr;
+    size_t length = 0;
+};
+
+/*函数调用的活动记录*/
+struct Frame {
+    size_t returnAddress; //CALL指令所在位置
+    size_t base;          //本帧槽位在slots中的起始下标
+    size_t stackMark;     //进入函数体时的操作数栈深度，返回时退栈到这里
+};
+
+/*操作数栈默认容量（元素个数），可用 setOperandStackLimit 修改；存储按需占用物理内存，默认值只占地址空间*/
+#ifndef PCODE_OPERAND_STACK_LIMIT
+#define PCODE_OPERAND_STACK_LIMIT (1 << 26)
+#endif
+
+/*
+ * 操作数栈：一次分配的连续存储，sp指向栈顶元素之上
+ * push不检查容量，净增长的指令在压栈前用full()检查是否溢出
+ */
+class OperandStack {
+public:
+    void reset(size_t limit) {
+        if (limit != capacity) {
+            storage.reset(new int[limit]); //不初始化，未用到的页不占物理内存
+            capacity = limit;
+        }
+        sp = storage.get();
+    }
+    bool full() const { return sp == storage.get() + capacity; }
+    size_t size() const { return sp - storage.get(); }
+    void push(int value) { *sp++ = value; }
+    int pop() { return *--sp; }
+    int& top() { return sp[-1]; }
+    int& fromTop(size_t n) { return sp[-1 - (ptrdiff_t)n]; } //栈顶往下第n个，栈顶为0
+    void dropTo(size_t mark) { sp = storage.get() + mark; } //整体退栈到深度mark
+    void drop(size_t n) { sp -= n; }
+
+private:
+    unique_ptr<int[]> storage;
+    size_t capacity = 0;
+    int* sp = nullptr;
+};
+
+/*printf格式串在加载时拆成字面量段和占位符段，执行时不再扫描格式串*/
+enum FormatSegmentKind : uint8_t {
+    FORMAT_LITERAL,
+    FORMAT_INT,  // %d
+    FORMAT_CHAR, // %c
+};
+
+struct FormatSegment {
+    FormatSegmentKind kind;
+    uint32_t offset; //字面量在FormatPlan::text中的位置
+    uint32_t length;
+};
+
+struct FormatPlan {
+    string text; //所有字面量段拼在一起，\n 已转成换行
+    vector<FormatSegment> segments;
+    int argCount = 0;
+};
+
+/*加载后指令占用的内存*/
+struct InstructionMemory {
+    size_t count = 0;
+    size_t textBytes = 0;    //文本形式(PCodeLine)
+    size_t encodedBytes = 0; //定长编码加字符串池
 };
 
 class PCodeInterpreter {
 public:
-    void run(const string& filename,const string& result);
+    bool run(const string& filename,const string& result);
+    bool run(const string& filename,int resultFd); //结果直接写到文件描述符，如1(stdout)
+    void load(const string& filename);
+    void loadCode(const string& code); //加载内存中的P-code文本
+    void loadProgram(const vector<PCodeLine>& code); //加载代码生成得到的指令表，不经过文本
+    bool runLoaded(const string& result); //执行已加载的程序；结果无法打开或写出、或执行出错中止时返回false
+    bool runLoaded(int resultFd);
+    const InstructionMemory& instructionMemory() const { return memory; }
+    void setOperandStackLimit(size_t limit) { operandStackLimit = limit; }
+    void setOutputBufferSize(size_t size) { output.setBufferSize(size); }
 
 private:
-    ofstream   outputfile;
+    OutputSink output;
     vector<Instruction> instructions;
+    vector<string> strings; //标签名、函数名
+    vector<FormatPlan> formats; //PRINT的格式计划
+    InstructionMemory memory;
     size_t programCounter;
-    //unordered_map<string, stack<vector<int>>> variables;//变量和数组合一
-    unordered_map<string, stack<shared_ptr<vector<int>>>> variables;
-    unordered_map<string, stack<bool>> varischar; 
-    unordered_map<string, stack<bool>> varisarray;
-    std::stack<int> numstack;
-    stack<vector<int>> tmpintvecs;//传参临时数组
-    stack<string> vecsname;//实参的名字
-    unordered_map<string,stack<shared_ptr<vector<int>>>> sarray2namemap;//形参实参数组对照修改:实参
-    unordered_map<string,stack<shared_ptr<vector<int>>>> xarray2namemap;//形参实参数组对照修改:形参
-
-    std::stack<int> callStack;  // 用于保存函数调用时的返回地址
-    vector<int> paramStack;  // 用于保存函数参数
+    vector<int> slots; //全局变量和各活动帧的标量，连续存放
+    vector<ArrayView> arrays; //与slots下标一一对应，数组变量当前绑定的存储
+    vector<vector<int>> ownedArrays; //STORE_arraysize分配的数组存储，随块或帧释放
+    vector<Frame> frames;
+    int globalSlotCount = 0;
+    int mainFrameSize = 0;
+    OperandStack numstack;
+    size_t operandStackLimit = PCODE_OPERAND_STACK_LIMIT;
+    bool aborted = false; //执行因错误（如操作数栈溢出）中止
+    vector<ArrayView> arrayArgs; //数组实参，按视图传递
+
     int arraysize;
     int arrayindex;
-    unordered_map<string, int> functable;
 
 
-    vector<Instruction> parsePCodeFile(const string& filename);
+    vector<PCodeLine> parsePCode(istream& input);
+    void assemble(const vector<PCodeLine>& lines);
+    int compileFormat(const string& format);
+    void fuseSuperinstructions();
+    bool start();
     void execute();
+    void returnFromCall();
+
+    size_t slotIndex(const Instruction& instr) const {
+        return (instr.flags & SLOT_GLOBAL) ? instr.a : frames.back().base + instr.a;
+    }
 };
 
 #endif // PCODE_INTERPRETER_H
\ No newline at end of file
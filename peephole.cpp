@@ -0,0 +1,248 @@
+#include "peephole.h"
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+/*带目标标签的跳转；CALL 的目标是函数，不在这里处理*/
+static bool isLabelJump(Opcode opcode) {
+    return opcode == JUMP || opcode == JUMP_IF_FALSE || opcode == JUMP_IF_FALSE_SHORT || opcode == JUMP_IF_TRUE_SHORT;
+}
+
+/*删掉 dead 标记的指令，返回删掉的条数*/
+static size_t compact(vector<PCodeLine>& code, const vector<bool>& dead) {
+    size_t kept = 0;
+    for (size_t i = 0; i < code.size(); i++) {
+        if (!dead[i]) {
+            if (kept != i) {
+                code[kept] = move(code[i]);
+            }
+            kept++;
+        }
+    }
+    size_t removed = code.size() - kept;
+    code.resize(kept);
+    return removed;
+}
+
+static unordered_map<string, size_t> labelPositions(const vector<PCodeLine>& code) {
+    unordered_map<string, size_t> labels;
+    for (size_t i = 0; i < code.size(); i++) {
+        if (code[i].opcode == LABEL) {
+            labels.emplace(code[i].operands[0], i);
+        }
+    }
+    return labels;
+}
+
+/*FUNC_DEF 后面的 JUMP 和函数入口（FUNC_DEF 之后第 2 条）的位置不能变*/
+static vector<bool> functionHeads(const vector<PCodeLine>& code) {
+    vector<bool> fixed(code.size(), false);
+    for (size_t i = 0; i + 1 < code.size(); i++) {
+        if (code[i].opcode == FUNC_DEF && code[i + 1].opcode == JUMP) {
+            fixed[i + 1] = true;
+            if (i + 2 < code.size()) {
+                fixed[i + 2] = true;
+            }
+        }
+    }
+    return fixed;
+}
+
+static size_t removeZheng(vector<PCodeLine>& code) {
+    vector<bool> dead(code.size(), false);
+    for (size_t i = 0; i < code.size(); i++) {
+        dead[i] = code[i].opcode == ZHENG;
+    }
+    return compact(code, dead);
+}
+
+/*PUSH a / FU → PUSH -a，按补码回绕，与解释器的 FU 相同*/
+static size_t foldNegatedPush(vector<PCodeLine>& code) {
+    vector<bool> dead(code.size(), false);
+    for (size_t i = 0; i + 1 < code.size(); i++) {
+        if (code[i].opcode == PUSH && code[i + 1].opcode == FU) {
+            long long value = stoll(code[i].operands[0]);
+            code[i].operands[0] = to_string(static_cast<int>(static_cast<uint32_t>(-value)));
+            dead[++i] = true;
+        }
+    }
+    return compact(code, dead);
+}
+
+/*PUSH c / JUMP_IF_FALSE L：c 为 0 时总是跳，换成 JUMP L；否则两条都删*/
+static size_t foldConstBranches(vector<PCodeLine>& code) {
+    vector<bool> dead(code.size(), false);
+    vector<bool> fixed = functionHeads(code);
+    for (size_t i = 0; i + 1 < code.size(); i++) {
+        if (code[i].opcode != PUSH || code[i + 1].opcode != JUMP_IF_FALSE || fixed[i] || fixed[i + 1]) {
+            continue;
+        }
+        if (stoll(code[i].operands[0]) == 0) {
+            code[i] = {JUMP, move(code[i + 1].operands)};
+            dead[i + 1] = true;
+        } else {
+            dead[i] = dead[i + 1] = true;
+        }
+        i++;
+    }
+    return compact(code, dead);
+}
+
+/*
+ * 跳转的目标处（跳过连续的 LABEL）是 JUMP M 时改成直接跳 M，沿链一直走到不是 JUMP 的地方
+ * 链上有环（如空循环体的 for(;;)）或走到未定义的标签时不改
+ */
+static size_t threadJumps(vector<PCodeLine>& code) {
+    unordered_map<string, size_t> labels = labelPositions(code);
+    size_t threaded = 0;
+    for (auto& line : code) {
+        if (!isLabelJump(line.opcode) || !labels.count(line.operands[0])) {
+            continue;
+        }
+        const string* target = &line.operands[0];
+        vector<const string*> visited = {target}; // 链一般只有一两步，线性查找
+        bool cycle = false;
+        while (true) {
+            size_t k = labels.find(*target)->second;
+            while (k < code.size() && code[k].opcode == LABEL) {
+                k++;
+            }
+            if (k == code.size() || code[k].opcode != JUMP || !labels.count(code[k].operands[0])) {
+                break;
+            }
+            const string* next = &code[k].operands[0];
+            for (const string* seen : visited) {
+                cycle = cycle || *seen == *next;
+            }
+            if (cycle) {
+                break;
+            }
+            visited.push_back(next);
+            target = next;
+        }
+        if (!cycle && target != &line.operands[0]) {
+            line.operands[0] = *target;
+            threaded++;
+        }
+    }
+    return threaded;
+}
+
+/*目标就在后面（中间只隔着 LABEL）的 JUMP、JUMP_IF_FALSE_SHORT、JUMP_IF_TRUE_SHORT；后两个不弹栈，删掉不影响栈*/
+static size_t removeJumpsToNext(vector<PCodeLine>& code) {
+    vector<bool> dead(code.size(), false);
+    vector<bool> fixed = functionHeads(code);
+    for (size_t i = 0; i < code.size(); i++) {
+        Opcode opcode = code[i].opcode;
+        if ((opcode != JUMP && opcode != JUMP_IF_FALSE_SHORT && opcode != JUMP_IF_TRUE_SHORT) || fixed[i]) {
+            continue;
+        }
+        for (size_t k = i + 1; k < code.size() && code[k].opcode == LABEL; k++) {
+            if (code[k].operands[0] == code[i].operands[0]) {
+                dead[i] = true;
+                break;
+            }
+        }
+    }
+    return compact(code, dead);
+}
+
+/*
+ * 顺序扫描：JUMP 和 main 以外函数里的 RETURN/RETURN_NULL 之后执行不到，直到下一个 LABEL、FUNC_DEF 或函数入口
+ * LABEL、FUNC_DEF、END_FUNC 保留，标签是否还有用由 removeUnusedLabels 决定
+ */
+static size_t removeUnreachable(vector<PCodeLine>& code) {
+    vector<bool> dead(code.size(), false);
+    vector<bool> fixed = functionHeads(code);
+    bool live = true;
+    bool returnEnds = false; // 当前函数里 RETURN 是否结束执行
+    for (size_t i = 0; i < code.size(); i++) {
+        Opcode opcode = code[i].opcode;
+        if (opcode == FUNC_DEF) {
+            returnEnds = code[i].operands[0] != "main";
+        }
+        if (opcode == LABEL || opcode == FUNC_DEF || fixed[i]) {
+            live = true;
+        }
+        if (!live && opcode != LABEL && opcode != END_FUNC) {
+            dead[i] = true;
+            continue;
+        }
+        if (opcode == JUMP || (returnEnds && (opcode == RETURN || opcode == RETURN_NuLL))) {
+            live = false;
+        }
+    }
+    return compact(code, dead);
+}
+
+/*
+ * STORE x / LOAD x → STORE_KEEP x，只对标量；DEF_VAR 的类型按文本顺序记录，与解释器加载时相同
+ * 后面紧跟 PUSH c / ADD(SUB) / STORE x 时不合并，留给加载时融合成 INC_VAR
+ */
+static size_t foldStoreLoad(vector<PCodeLine>& code) {
+    vector<bool> dead(code.size(), false);
+    unordered_set<string> arraySlots;
+    for (size_t i = 0; i < code.size(); i++) {
+        const PCodeLine& line = code[i];
+        if (line.opcode == FUNC_DEF) {
+            for (auto it = arraySlots.begin(); it != arraySlots.end();) {
+                it = (*it)[0] == 'L' ? arraySlots.erase(it) : next(it);
+            }
+        } else if (line.opcode == DEF_VAR) {
+            if (line.operands[0].find("Array") != string::npos) {
+                arraySlots.insert(line.operands[1]);
+            } else {
+                arraySlots.erase(line.operands[1]);
+            }
+        }
+        if (line.opcode != STORE || i + 1 == code.size() || code[i + 1].opcode != LOAD) {
+            continue;
+        }
+        const string& slot = line.operands[0];
+        if (code[i + 1].operands[0] != slot || arraySlots.count(slot)) {
+            continue;
+        }
+        if (i + 4 < code.size() && code[i + 2].opcode == PUSH && (code[i + 3].opcode == ADD || code[i + 3].opcode == SUB)
+            && code[i + 4].opcode == STORE && code[i + 4].operands[0] == slot) {
+            continue;
+        }
+        code[i].opcode = STORE_KEEP;
+        dead[++i] = true;
+    }
+    return compact(code, dead);
+}
+
+static size_t removeUnusedLabels(vector<PCodeLine>& code) {
+    unordered_set<string> used;
+    for (const auto& line : code) {
+        if (isLabelJump(line.opcode)) {
+            used.insert(line.operands[0]);
+        }
+    }
+    vector<bool> dead(code.size(), false);
+    for (size_t i = 0; i < code.size(); i++) {
+        dead[i] = code[i].opcode == LABEL && !used.count(code[i].operands[0]);
+    }
+    return compact(code, dead);
+}
+
+PeepholeStats peepholeOptimize(vector<PCodeLine>& code) {
+    PeepholeStats stats;
+    bool changed = true;
+    while (changed) {
+        size_t before = code.size();
+        stats.zheng += removeZheng(code);
+        stats.negatedPush += foldNegatedPush(code);
+        stats.constBranches += foldConstBranches(code);
+        size_t threaded = threadJumps(code);
+        stats.threadedJumps += threaded;
+        stats.jumpToNext += removeJumpsToNext(code);
+        stats.unreachable += removeUnreachable(code);
+        stats.storeLoad += foldStoreLoad(code);
+        stats.unusedLabels += removeUnusedLabels(code);
+        stats.passes++;
+        changed = code.size() != before || threaded > 0;
+    }
+    return stats;
+}
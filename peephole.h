@@ -0,0 +1,36 @@
+#ifndef PEEPHOLE_H
+#define PEEPHOLE_H
+
+#include <cstddef>
+#include <vector>
+#include "pcode.h"
+
+using namespace std;
+
+/*各条规则的效果；threadedJumps 只改跳转目标，不删指令*/
+struct PeepholeStats {
+    size_t zheng = 0;          // 删掉的 ZHENG
+    size_t negatedPush = 0;    // PUSH a / FU 合并成 PUSH -a
+    size_t constBranches = 0;  // PUSH c / JUMP_IF_FALSE 按 c 换成 JUMP 或删掉
+    size_t jumpToNext = 0;     // 跳到下一条指令的跳转
+    size_t threadedJumps = 0;  // 跳到 JUMP 上的跳转改跳最终目标
+    size_t unreachable = 0;    // RETURN/JUMP 之后执行不到的指令
+    size_t storeLoad = 0;      // STORE x / LOAD x 合并成 STORE_KEEP x
+    size_t unusedLabels = 0;   // 没有跳转引用的 LABEL
+    size_t passes = 0;         // 到不动点为止的轮数
+
+    size_t removed() const {
+        return zheng + negatedPush + constBranches + jumpToNext + unreachable + storeLoad + unusedLabels;
+    }
+};
+
+/*
+ * 窥孔优化：代码生成之后、解释器加载之前在指令表上改写，各条规则轮流做，直到一轮里没有任何改动
+ * 保持解释器现有的行为：
+ *   函数从 FUNC_DEF 之后第 2 条进入（CALL 的入口），FUNC_DEF 和它后面的 JUMP 不动；
+ *   main 里的 RETURN 不结束程序，之后的代码仍然执行，不算执行不到；
+ *   JUMP_IF_FALSE 会弹栈，跳到下一条时不能删；跳到未定义标签的跳转不改
+ */
+PeepholeStats peepholeOptimize(vector<PCodeLine>& code);
+
+#endif // PEEPHOLE_H
@@ -0,0 +1,75 @@
+#include "pipeline.h"
+#include "lexer.h"
+#include "parser.h"
+#include "semantic_analyzer.h"
+#include "const_fold.h"
+#include "codegen.h"
+#include "peephole.h"
+#include "shared.h"
+#include "trace.h"
+#include <fstream>
+
+CompileResult compileSource(const string& source, const CompileOptions& options) {
+    CompileResult result;
+
+    //注释由词法分析跳过，去注释后的文本只在需要时写出
+    if (options.dumpStripped) {
+        ofstream("testfile2.txt") << replaceCommentsWithSpaces(source);
+    }
+
+    // 词法分析
+    Lexer lexer("", options.dumpTokens ? "lexer.txt" : "", options.dumpPhaseErrors ? "lexer_error.txt" : "");
+    lexer.setBackend(options.lexerBackend);
+    lexer.analyzeSource(source);
+    TokenStream tokens = lexer.takeTokens();
+    TRACE(TRACE_PHASE, "lexer: " << tokens.size() << " tokens (" << lexer.backend().name << ")");
+
+    // 语法分析
+    Parser parser(tokens, options.dumpParse ? "parser.txt" : "", options.dumpPhaseErrors ? "parser_error.txt" : "");
+    SyntaxTree ast = parser.parse();
+    TRACE(TRACE_PHASE, "parser: done");
+
+    // 语义分析：检查错误并把槽位标注到语法树上
+    SemanticAnalyzer semanticAnalyzer(ast);
+    semanticAnalyzer.analyze();
+    TRACE(TRACE_PHASE, "semantic analysis: " << semanticAnalyzer.getErrorLines().size() << " errors");
+    if (options.dumpSymbols) {
+        semanticAnalyzer.getSymbolTable().dumpSymbolTable("symbol.txt");
+    }
+    if (options.dumpPhaseErrors) {
+        ofstream symbolErrors("symbol_error.txt");
+        for (const auto& line : semanticAnalyzer.getErrorLines()) {
+            symbolErrors << line << '\n';
+        }
+    }
+
+    // 常量折叠：结果标在语法树上，由代码生成使用
+    if (options.foldConstants) {
+        FoldStats folded = ConstantFolder().fold(semanticAnalyzer.getSyntaxTree().root);
+        TRACE(TRACE_PHASE, "const fold: " << folded.operations << " operations, " << folded.propagated << " constants propagated");
+    }
+
+    // 代码生成
+    result.code = CodeGenerator().generate(semanticAnalyzer.getSyntaxTree().root);
+    TRACE(TRACE_PHASE, "codegen: " << result.code.size() << " instructions");
+
+    // 窥孔优化：在指令表上改写，P_code.txt 写出的是优化后的指令
+    if (options.peephole) {
+        PeepholeStats peephole = peepholeOptimize(result.code);
+        TRACE(TRACE_PHASE, "peephole: " << peephole.removed() << " removed in " << peephole.passes << " passes ("
+              << peephole.zheng << " ZHENG, " << peephole.negatedPush << " PUSH/FU, "
+              << peephole.constBranches << " constant branches, " << peephole.jumpToNext << " jumps to next, "
+              << peephole.unreachable << " unreachable, " << peephole.storeLoad << " STORE/LOAD, "
+              << peephole.unusedLabels << " labels; " << peephole.threadedJumps << " jumps threaded)");
+    }
+    if (options.dumpPCode) {
+        ofstream("P_code.txt") << formatPCode(result.code);
+    }
+
+    // 合并各阶段的错误
+    vector<string> errors = lexer.getErrorLines();
+    errors.insert(errors.end(), parser.getErrorLines().begin(), parser.getErrorLines().end());
+    errors.insert(errors.end(), semanticAnalyzer.getErrorLines().begin(), semanticAnalyzer.getErrorLines().end());
+    result.errors = mergeErrorLines(move(errors));
+    return result;
+}
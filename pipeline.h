@@ -0,0 +1,34 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <string>
+#include <vector>
+#include "lexer_scan.h"
+#include "pcode.h"
+
+using namespace std;
+
+/*
+ * 编译流水线：源程序 → Token（词法分析时跳过注释）→ AST → 标注过的 AST →（常量折叠）→ 指令表 →（窥孔优化），各阶段的结果只在内存中传递
+ * 中间文件默认不写，按下面的标志写出，文件名与原来分阶段经文件传递时相同
+ */
+struct CompileOptions {
+    bool dumpStripped = false;    // testfile2.txt
+    bool dumpTokens = false;      // lexer.txt
+    bool dumpParse = false;       // parser.txt
+    bool dumpSymbols = false;     // symbol.txt
+    bool dumpPCode = false;       // P_code.txt
+    bool dumpPhaseErrors = false; // lexer_error.txt、parser_error.txt、symbol_error.txt
+    bool foldConstants = true;    // 代码生成前做常量折叠与传播（const_fold.h）
+    bool peephole = true;         // 代码生成后做窥孔优化（peephole.h）
+    LexerBackend lexerBackend = LEXER_AUTO;
+};
+
+struct CompileResult {
+    vector<string> errors; //"行号 错误码"，按行号排序并去重
+    vector<PCodeLine> code; //直接交给 PCodeInterpreter::loadProgram
+};
+
+CompileResult compileSource(const string& source, const CompileOptions& options = CompileOptions());
+
+#endif // PIPELINE_H
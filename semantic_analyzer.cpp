@@ -6,19 +6,11 @@
 #include <string>
 #include "parser.h"
 #include <sstream>
+#include "trace.h"
 
 using namespace std;
 
 int blocks2level = 0;
-int funcLevel = 0;
-int labelscope = 0;
-int labelfor_bk_ctn = 0;
-int if_order = 0;
-int continue_order = 0;
-int break_continu = 0;
-int shortvalorder = 0;
-vector<string> return_pop_varsparams;
-vector<string> return_pop_varsin;
 
 std::vector<int> hasReturnStatement(ASTNode* node) {
     std::vector<int> returnLines;
@@ -27,25 +19,25 @@ std::vector<int> hasReturnStatement(ASTNode* node) {
     switch (node->type) {
         case NODE_FUNCDEF: {
             auto funcDefNode = static_cast<FuncDefNode*>(node);
-            auto blockReturnLines = hasReturnStatement(funcDefNode->block.get());
+            auto blockReturnLines = hasReturnStatement(funcDefNode->block);
             returnLines.insert(returnLines.end(), blockReturnLines.begin(), blockReturnLines.end());
             break;
         }
         case NODE_BLOCK: {
             auto blockNode = static_cast<BlockNode*>(node);
             for (auto& stmt : blockNode->stmts) {
-                auto stmtReturnLines = hasReturnStatement(stmt.get());
+                auto stmtReturnLines = hasReturnStatement(stmt);
                 returnLines.insert(returnLines.end(), stmtReturnLines.begin(), stmtReturnLines.end());
             }
             break;
         }
         case NODE_IFSTMT: {
             auto ifStmtNode = static_cast<IfStmtNode*>(node);
-            auto thenReturnLines = hasReturnStatement(ifStmtNode->thenStmt.get());
+            auto thenReturnLines = hasReturnStatement(ifStmtNode->thenStmt);
             returnLines.insert(returnLines.end(), thenReturnLines.begin(), thenReturnLines.end());
 
             if (ifStmtNode->elseStmt) {
-                auto elseReturnLines = hasReturnStatement(ifStmtNode->elseStmt.get());
+                auto elseReturnLines = hasReturnStatement(ifStmtNode->elseStmt);
                 returnLines.insert(returnLines.end(), elseReturnLines.begin(), elseReturnLines.end());
             }
             break;
@@ -69,11 +61,11 @@ int checkMainFunctionReturn(ASTNode* node) {
     switch (node->type) {
         case NODE_MAINFUNCDEF: {
             auto mainFuncDefNode = static_cast<MainFuncDefNode*>(node);
-            return checkMainFunctionReturn(mainFuncDefNode->block.get());
+            return checkMainFunctionReturn(mainFuncDefNode->block);
         }
         case NODE_FUNCDEF: {
             auto funcDefNode = static_cast<FuncDefNode*>(node);
-            return checkMainFunctionReturn(funcDefNode->block.get());
+            return checkMainFunctionReturn(funcDefNode->block);
         }
         case NODE_BLOCK: {
             auto blockNode = static_cast<BlockNode*>(node);
@@ -89,14 +81,12 @@ int checkMainFunctionReturn(ASTNode* node) {
     }
 }
 
-void SemanticAnalyzer::analyze(const string& Sem_OutputFile, const string& Sem_ErrorFile, const string& Intmi_codeFile) {
-    errorOutput.open(Sem_ErrorFile);
-    codeOutput.open(Intmi_codeFile);
+void SemanticAnalyzer::analyze() {
+    /*作用域序号是文件作用域的全局量，每次分析前清零，同一进程可以编译多个程序*/
+    blocks2level = 0;
+    errorLines.clear();
     symbolTable.enterScope(++blocks2level); 
-    traverseAST(ast.get());
-    symbolTable.dumpSymbolTable(Sem_OutputFile);
-    errorOutput.close();
-    codeOutput.close();
+    traverseAST(ast.root);
 }
 
 void SymbolTable::dumpSymbolTable(const string& filename) const {
@@ -105,16 +95,24 @@ void SymbolTable::dumpSymbolTable(const string& filename) const {
         cerr << "Error: Could not open file " << filename << " for writing." << endl;
         return;
     }
-    vector<SymbolEntry> entries;
-    // 收集所有符号表中的条目
-    for (int i = 0; i < smb_size; ++i) {
-        for (const auto& pair : scopeStack[i]) {
-            entries.push_back(pair.second);
-        }
+    struct Row {
+        int scopeLevel;
+        int order;
+        IdentId name;
+        const string* type;
+    };
+    vector<Row> entries;
+    entries.reserve(closedSymbols.size() + undoLog.size());
+    // 收集已关闭和仍打开的作用域中的条目
+    for (const auto& symbol : closedSymbols) {
+        entries.push_back({symbol.scopeLevel, symbol.order, symbol.name, &symbol.type});
+    }
+    for (const SymbolEntry* entry : undoLog) {
+        entries.push_back({entry->scopeLevel, entry->order, entry->name, &entry->type});
     }
 
     // 按照 scopeLevel 和 order 进行排序
-    sort(entries.begin(), entries.end(), [](const SymbolEntry& a, const SymbolEntry& b) {
+    sort(entries.begin(), entries.end(), [](const Row& a, const Row& b) {
         if (a.scopeLevel != b.scopeLevel) {
             return a.scopeLevel < b.scopeLevel;
         }
@@ -123,7 +121,7 @@ void SymbolTable::dumpSymbolTable(const string& filename) const {
 
     // 输出排序后的条目
     for (const auto& entry : entries) {
-        outputFile<< entry.scopeLevel <<" "<< entry.name <<" "<< entry.type <<endl;
+        outputFile<< entry.scopeLevel <<" "<< identifiers.name(entry.name) <<" "<< *entry.type <<endl;
     }
 
     outputFile.close();
@@ -266,18 +264,20 @@ void SemanticAnalyzer::traverseAST(ASTNode* node) {
             analyzeIfStmt(static_cast<IfStmtNode*>(node));
             break;
         // 其他节点类型
+        default:
+            break;
     }
 }
 
 void SemanticAnalyzer::analyzeCompUnit(CompUnitNode* node) {
     if (!node) return;
     for (auto& decl : node->decls) {
-        traverseAST(decl.get());
+        traverseAST(decl);
     }
     for (auto& funcDef : node->funcDefs) {
-        traverseAST(funcDef.get());
+        traverseAST(funcDef);
     }
-    traverseAST(node->mainFuncDef.get());
+    traverseAST(node->mainFuncDef);
 }
 
 void SemanticAnalyzer::analyzeDecl(DeclNode* node) {
@@ -290,54 +290,53 @@ void SemanticAnalyzer::analyzeDecl(DeclNode* node) {
             analyzeVarDecl(static_cast<VarDeclNode*>(node));
             break;
         // 其他声明类型
+        default:
+            break;
     }
 }
 
 void SemanticAnalyzer::analyzeConstDecl(ConstDeclNode* node) {
     if (!node) return;
     for (auto& constDef : node->constDefs) {
-        traverseAST(constDef.get());
+        traverseAST(constDef);
     }
 }
 
 void SemanticAnalyzer::analyzeConstDef(ConstDefNode* node) {
-    //codeOutput<<"constdef"<<endl;
+    //codeOutput<<"constdef"<<'\n';
     if (!node) return;
     // 检查常量定义的语义
     SymbolEntry entry;
     entry.name = node->name;
-    entry.type = node->constdeftype;
+    entry.type = string(node->constdeftype);
     entry.isConst = true;
     entry.isFunction = false;
     entry.paramTypes = {};
+    entry.constDef = node;
+    bool global = symbolTable.getCurrentLevel() == global_level;
+    entry.slot = alloc_slot(global);
     bool foundEntry = symbolTable.Isrepeated(entry.name);
-    int tmpscope = -1;
     if (foundEntry) {
         reportError(node->linenum, "b");
     } else {
         symbolTable.addSymbol(entry);
-        const SymbolEntry& lastAdded = symbolTable.getLastAddedSymbol();
-        tmpscope = lastAdded.scopeLevel;
     }
+    node->ref = {entry.slot, global};
 
-    def_pcode(node->constdeftype,node->name,tmpscope);
     if(node->arraysize){
-        traverseAST(node->arraysize.get());
-        arraysize_pcode(node->name,tmpscope);
-        for(int i=0;i<node->initVals.size();++i){
-            traverseAST(node->initVals[i].get());
-            arrayelement_pcode(node->name,i,tmpscope);
+        traverseAST(node->arraysize);
+        for(size_t i=0;i<node->initVals.size();++i){
+            traverseAST(node->initVals[i]);
         }
     } else {
-        traverseAST(node->initVals[0].get());
-        store_var(node->name,tmpscope);
+        traverseAST(node->initVals[0]);
     }
 }
 
 void SemanticAnalyzer::analyzeVarDecl(VarDeclNode* node) {
     if (!node) return;
     for (auto& varDef : node->varDefs) {
-        traverseAST(varDef.get());
+        traverseAST(varDef);
     }
 }
 
@@ -346,72 +345,51 @@ void SemanticAnalyzer::analyzeVarDef(VarDefNode* node) {
     // 检查变量定义的语义
     SymbolEntry entry;
     entry.name = node->name;
-    entry.type = node->vardeftype;
+    entry.type = string(node->vardeftype);
     entry.isConst = false;
-    int tmpscope = -1;
+    bool global = symbolTable.getCurrentLevel() == global_level;
+    entry.slot = alloc_slot(global);
     if (symbolTable.Isrepeated(entry.name)) {
         // 名字重定义错误
         reportError(node->linenum, "b");
     } else {
         symbolTable.addSymbol(entry);
-        const SymbolEntry& lastAdded = symbolTable.getLastAddedSymbol();
-        tmpscope = lastAdded.scopeLevel;
     }
-
-    def_pcode(node->vardeftype,node->name,tmpscope);
+    node->ref = {entry.slot, global};
     
     if(node->arraysize!=nullptr){
-        traverseAST(node->arraysize.get());
-        arraysize_pcode(node->name,tmpscope);
-        if(node->initVals.size()!=0){
-            for(int i=0;i<node->initVals.size();++i){
-                traverseAST(node->initVals[i].get());
-                arrayelement_pcode(node->name,i,tmpscope);
-            }
-        }
-    } else {
-        if(node->initVals.size()!=0){
-            for(int i=0;i<node->initVals.size();++i){
-                traverseAST(node->initVals[i].get());
-                store_var(node->name,tmpscope);
-            }
-        }
+        traverseAST(node->arraysize);
+    }
+    for(size_t i=0;i<node->initVals.size();++i){
+        traverseAST(node->initVals[i]);
     }
 }
 
-std::vector<std::string> getTopLevelDefNames(BlockNode* blockNode);
+std::vector<IdentId> getTopLevelDefNames(BlockNode* blockNode);
 
 void SemanticAnalyzer::analyzeFuncDef(FuncDefNode* node) {
     if (!node) return;
     // 检查函数定义的语义
     int level = symbolTable.getCurrentLevel();
-    funcLevel = blocks2level+1;
+    localSlotCount = 0; /*形参和局部变量的槽位从新帧的0开始*/
     SymbolEntry entry;
     entry.name = node->name;
     //cout<<"func name is "<<entry.name<<endl;
-    entry.type = node->funcdeftype;
+    entry.type = string(node->funcdeftype);
     entry.isFunction = true;
     entry.paramTypes = {};
-    int tmpscope = -1;
     if (symbolTable.Isrepeated(entry.name)) {
         // 名字重定义错误
         reportError(node->linenum, "b");
     } else {
         symbolTable.addSymbol(entry);
-        const SymbolEntry& lastAdded = symbolTable.getLastAddedSymbol();
-        tmpscope = lastAdded.scopeLevel;
     }
 
-    funcdef_pcode(node->funcdeftype, node->name,tmpscope);
-    codeOutput<<"JUMP "+node->name+"END_FUNC"<<endl;
-
     // 处理函数的参数
     if (node->params) {
-        entry.paramTypes = analyzeFuncFParams(static_cast<FuncFParamsNode*>(node->params.get()));
+        entry.paramTypes = analyzeFuncFParams(static_cast<FuncFParamsNode*>(node->params));
         symbolTable.insertparamtypes(entry);
     }
-    /*中间代码*/
-    codeOutput<<"FUNCBLOCKNOW"<<endl;/*进入func的block，记录numstack数量用于无效元素退栈*/
     //f
     if(entry.type == "VoidFunc"){
         vector<int> errlines = hasReturnStatement(node);
@@ -422,20 +400,8 @@ void SemanticAnalyzer::analyzeFuncDef(FuncDefNode* node) {
         }
     }
 
-    labelscope = symbolTable.getCurrentLevel();
-    if(node->params){
-        auto pamnode = static_cast<FuncFParamsNode*>(node->params.get());
-        for(int i=0;i<pamnode->params.size();i++){
-            auto paramnode = static_cast<FuncFParamNode*>(pamnode->params[i].get());
-            return_pop_varsparams.push_back(paramnode->name); /*需要pop定义的变量 */
-        }
-    }
-    
-    
-    //处理语句块
-    auto blocknode = static_cast<BlockNode*>(node->block.get());
-    return_pop_varsin = getTopLevelDefNames(blocknode);
-    traverseAST(node->block.get());
+    //处理语句块，形参和局部变量随函数帧一起释放
+    traverseAST(node->block);
     
     
     
@@ -446,53 +412,20 @@ void SemanticAnalyzer::analyzeFuncDef(FuncDefNode* node) {
         }
     }
 
-    /*生成中间代码*/
-    
-    if(return_pop_varsparams.size()){
-        for(auto it :return_pop_varsparams){
-            pop_var(it);
-        }
-    }
-    return_pop_varsparams.clear();
-    return_pop_varsin.clear();
-
-    labelfuncend(node->name);
-    end_func();
     symbolTable.exitScope(level);
 }
 
 vector<string> SemanticAnalyzer::analyzeFuncFParams(FuncFParamsNode* node) {
     vector<string> types;
-    int arrvarnumorder = 0;
-    int varnumorder = 0;
-    for(int i=0;i<node->params.size();i++){
-        auto paramnode = static_cast<FuncFParamNode*>(node->params[i].get());
-        if(paramnode->realtype.find("Array")!=string::npos){
-            arrvarnumorder++;
-        }else{
-            varnumorder++;
-        }
-    }
-    int tmparr=0;
-    int tmpvar=0;
-    for(int i=0;i<node->params.size();i++){
-        auto paramnode = static_cast<FuncFParamNode*>(node->params[i].get());
-        types.push_back(analyzeFuncFParam(paramnode));
-        def_pcode(paramnode->realtype,paramnode->name,0);/*标*/
-        if(paramnode->realtype.find("Array")!=string::npos){
-            codeOutput<<"STORE_funcf_arraysize "+paramnode->name<<endl;
-            load_arrparam(arrvarnumorder-1-tmparr,paramnode->name);
-            tmparr++;
-        } else {
-            load_param(varnumorder-1-tmpvar,paramnode->name);
-            tmpvar++;
-        }    //store_var(paramnode->name,0);
+    for(size_t i=0;i<node->params.size();i++){
+        auto paramnode = static_cast<FuncFParamNode*>(node->params[i]);
+        types.push_back(analyzeFuncFParam(paramnode, alloc_slot(false)));
     }
     
     return types;
 }
 
-string SemanticAnalyzer::analyzeFuncFParam(FuncFParamNode* node) {
+string SemanticAnalyzer::analyzeFuncFParam(FuncFParamNode* node, int slot) {
     // 检查函数参数的语义
     SymbolEntry entry;
     entry.name = node->name;
@@ -510,36 +443,29 @@ string SemanticAnalyzer::analyzeFuncFParam(FuncFParamNode* node) {
     entry.isConst = false;
     entry.isFunction = false;
     entry.isArray = node->isArray;
+    entry.slot = slot;
+    node->ref = {slot, false};
     symbolTable.enterScope(blocks2level+1);//形参作用域
 
-    int tmpscope = -1;
-
     if (symbolTable.Isrepeated(entry.name)) {
         // 名字重定义错误
         reportError(node->linenum, "b");
     } else {
         symbolTable.addSymbol(entry);
-        const SymbolEntry& lastAdded = symbolTable.getLastAddedSymbol();
-        tmpscope = lastAdded.scopeLevel;
     }
 
-    //def_pcode(entry.type,entry.name,tmpscope); //传参不会有数组？
-
     return entry.type;
 }
 
 void SemanticAnalyzer::analyzeMainFuncDef(MainFuncDefNode* node) {
     if (!node) return;
     // 检查主函数定义的语义
-    funcdef_pcode("","main",0);
-    funcLevel = blocks2level+1;
-    traverseAST(node->block.get());
+    localSlotCount = 0;
+    traverseAST(node->block);
     int checkreturn = checkMainFunctionReturn(node);
     if(checkreturn != -1){
         reportError(checkreturn,"g");
     }
-    labelfuncend("main");
-    end_func();
 }
 //m
 vector<int> hasContinueOrBreak(BlockNode* blockNode) {
@@ -550,17 +476,17 @@ vector<int> hasContinueOrBreak(BlockNode* blockNode) {
         if (!stmt) continue;
         switch (stmt->type) {
             case NODE_BREAKSTMT: {
-                auto breakstmt = static_cast<BreakStmtNode*>(stmt.get());
+                auto breakstmt = static_cast<BreakStmtNode*>(stmt);
                 result.push_back(breakstmt->breaklinenum);
                 break;
             }
             case NODE_CONTINUESTMT: {
-                auto continuestmt = static_cast<ContinueStmtNode*>(stmt.get());
+                auto continuestmt = static_cast<ContinueStmtNode*>(stmt);
                 result.push_back(continuestmt->continuelinenum);
                 break;
             }
             case NODE_BLOCK: {
-                std::vector<int> nestedResult = hasContinueOrBreak(static_cast<BlockNode*>(stmt.get()));
+                std::vector<int> nestedResult = hasContinueOrBreak(static_cast<BlockNode*>(stmt));
                 result.insert(result.end(), nestedResult.begin(), nestedResult.end());
                 break;
             }
@@ -572,23 +498,23 @@ vector<int> hasContinueOrBreak(BlockNode* blockNode) {
     return result;
 }
 /*做POP_VAR用的 */
-std::vector<std::string> getTopLevelDefNames(BlockNode* blockNode) {
-    std::vector<std::string> defNames;
+std::vector<IdentId> getTopLevelDefNames(BlockNode* blockNode) {
+    std::vector<IdentId> defNames;
     if (!blockNode) return defNames;
 
     for (auto& stmt : blockNode->stmts) {
         if (stmt->type == NODE_CONSTDECL || stmt->type == NODE_VARDECL) {
             // 处理常量声明或变量声明
             if (stmt->type == NODE_CONSTDECL) {
-                auto constDeclNode = static_cast<ConstDeclNode*>(stmt.get());
+                auto constDeclNode = static_cast<ConstDeclNode*>(stmt);
                 for (auto& constDef : constDeclNode->constDefs) {
-                    auto constDefNode = static_cast<ConstDefNode*>(constDef.get());
+                    auto constDefNode = static_cast<ConstDefNode*>(constDef);
                     defNames.push_back(constDefNode->name);
                 }
             } else if (stmt->type == NODE_VARDECL) {
-                auto varDeclNode = static_cast<VarDeclNode*>(stmt.get());
+                auto varDeclNode = static_cast<VarDeclNode*>(stmt);
                 for (auto& varDef : varDeclNode->varDefs) {
-                    auto varDefNode = static_cast<VarDefNode*>(varDef.get());
+                    auto varDefNode = static_cast<VarDefNode*>(varDef);
                     defNames.push_back(varDefNode->name);
                 }
             }
@@ -607,7 +533,7 @@ void SemanticAnalyzer::analyzeBlock(BlockNode* node) {
     int level = symbolTable.getCurrentLevel();
     symbolTable.enterScope(++blocks2level);
     for (auto& stmt : node->stmts) {
-        traverseAST(stmt.get());
+        traverseAST(stmt);
     }
     
     //错误m
@@ -620,12 +546,13 @@ void SemanticAnalyzer::analyzeBlock(BlockNode* node) {
         }
     }
 
-    labelscope = symbolTable.getCurrentLevel();
-    /*生成中间代码*/
-    vector<string> names = getTopLevelDefNames(node);
-    /*有问题*/
+    /*块结束时退出本层定义的变量，由代码生成写成 POP_VAR*/
+    vector<IdentId> names = getTopLevelDefNames(node);
     for(auto popvarname: names){
-        pop_var(popvarname);
+        auto entry = symbolTable.lookup(popvarname);
+        if(entry && entry->scopeLevel == symbolTable.getCurrentLevel()){
+            node->popVars.push_back(slotOf(*entry));
+        }
     }
 
     symbolTable.exitScope(level);
@@ -633,14 +560,14 @@ void SemanticAnalyzer::analyzeBlock(BlockNode* node) {
 
 void SemanticAnalyzer::analyzeStmt(StmtNode* node) {
     if (!node) return;
-    cout<<"analyze stmt"<<endl;
+    TRACE(TRACE_DETAIL, "analyze stmt");
     // 检查语句的语义
     //语法分析无返回
 }
 
 void SemanticAnalyzer::analyzeExp(ExpNode* node) {
     if (!node) return;
-    cout << "analyze exp" << endl;
+    TRACE(TRACE_DETAIL, "analyze exp");
     // 检查表达式的语义
     // 语法分析的时候就转add了
 }
@@ -651,39 +578,23 @@ void SemanticAnalyzer::analyzeCondExp(CondExpNode* node) {
     //语法没有返回这个
 }
 
-void SemanticAnalyzer::analyzeLVal(LValNode* node, bool islight) {
+void SemanticAnalyzer::analyzeLVal(LValNode* node) {
     if (!node) return;
     //cout<<"LVAL"<<endl;
     
     // 检查左值的语义
-    auto symbol = symbolTable.Isundefined(node->name,funcLevel);
+    auto symbol = symbolTable.Isundefined(node->name);
     if (symbol) {
         reportError(node->linenum, "c");
     }
 
     auto entry = symbolTable.lookup(node->name);
+    node->ref = entry ? slotOf(*entry) : SlotRef();
+    node->constDef = entry ? entry->constDef : nullptr;
     // 分析索引表达式
     if(node->indice){
-        traverseAST(node->indice.get()); //类似于a[0]的[0]
-        if(entry){
-            store_arrayindex();
-            if(islight){
-                arrayelement_pcode(entry->name,-1,entry->scopeLevel);
-                //-1代表去取index
-            } else {
-                load_arrayelement(entry->name,entry->scopeLevel);
-            }
-        }
-    }else{
-        if(entry){
-            if(islight){
-                store_var(entry->name,entry->scopeLevel);
-            } else {
-                load_var(entry->name,entry->scopeLevel);
-            }
-        }
+        traverseAST(node->indice); //类似于a[0]的[0]
     }
-    
 }
 
 void SemanticAnalyzer::analyzePrimaryExp(PrimaryExpNode* node) {
@@ -696,25 +607,7 @@ void SemanticAnalyzer::analyzeUnaryExp(UnaryExpNode* node) {
     if (!node) return;
     // 检查一元表达式的语义
     if(node->unaryexp){
-        traverseAST(node->unaryexp.get());
-    }
-
-    if(node->unaryop){
-        switch (node->unaryop)
-        {
-        case PLUS:
-            codeOutput<<"ZHENG"<<endl;
-            break;
-        case MINU:
-            codeOutput<<"FU"<<endl;
-            break;
-        case NOT:{
-            codeOutput<<"FEI"<<endl;
-            break;
-        }
-        default:
-            break;
-        }
+        traverseAST(node->unaryexp);
     }
 }
 /*
@@ -729,7 +622,7 @@ string SemanticAnalyzer::getExpType(ASTNode* node) {
         case NODE_CHARACTER:
             return "Char";
         case NODE_LVAL: {
-            LValNode* lvalNode = dynamic_cast<LValNode*>(node);
+            LValNode* lvalNode = static_cast<LValNode*>(node);
             if (!lvalNode) return "";
             auto entry = symbolTable.lookup(lvalNode->name);
             if (entry) {
@@ -743,7 +636,7 @@ string SemanticAnalyzer::getExpType(ASTNode* node) {
             }
         }
         case NODE_FUNCRPARAMS: {
-            FuncRParamsNode* funcRParamsNode = dynamic_cast<FuncRParamsNode*>(node);
+            FuncRParamsNode* funcRParamsNode = static_cast<FuncRParamsNode*>(node);
             if (!funcRParamsNode) return "";
             auto entry = symbolTable.lookup(funcRParamsNode->name);
             if (entry) {
@@ -760,34 +653,34 @@ string SemanticAnalyzer::getExpType(ASTNode* node) {
             }
         }
         case NODE_ADDEXP: {
-            AddExpNode* addExpNode = dynamic_cast<AddExpNode*>(node);
+            AddExpNode* addExpNode = static_cast<AddExpNode*>(node);
             if (!addExpNode || addExpNode->operands.empty()) return "";
-            return getExpType(addExpNode->operands[0].get());
+            return getExpType(addExpNode->operands[0]);
         }
         case NODE_MULEXP: {
-            MulExpNode* mulExpNode = dynamic_cast<MulExpNode*>(node);
+            MulExpNode* mulExpNode = static_cast<MulExpNode*>(node);
             if (!mulExpNode || mulExpNode->operands.empty()) return "";
-            return getExpType(mulExpNode->operands[0].get());
+            return getExpType(mulExpNode->operands[0]);
         }
         case NODE_RELEXP: {
-            RelExpNode* relExpNode = dynamic_cast<RelExpNode*>(node);
+            RelExpNode* relExpNode = static_cast<RelExpNode*>(node);
             if (!relExpNode || relExpNode->operands.empty()) return "";
-            return getExpType(relExpNode->operands[0].get());
+            return getExpType(relExpNode->operands[0]);
         }
         case NODE_EQEXP: {
-            EqExpNode* eqExpNode = dynamic_cast<EqExpNode*>(node);
+            EqExpNode* eqExpNode = static_cast<EqExpNode*>(node);
             if (!eqExpNode || eqExpNode->operands.empty()) return "";
-            return getExpType(eqExpNode->operands[0].get());
+            return getExpType(eqExpNode->operands[0]);
         }
         case NODE_LANDEXP: {
-            LandExpNode* landExpNode = dynamic_cast<LandExpNode*>(node);
+            LandExpNode* landExpNode = static_cast<LandExpNode*>(node);
             if (!landExpNode || landExpNode->operands.empty()) return "";
-            return getExpType(landExpNode->operands[0].get());
+            return getExpType(landExpNode->operands[0]);
         }
         case NODE_LOREXP: {
-            LorExpNode* lorExpNode = dynamic_cast<LorExpNode*>(node);
+            LorExpNode* lorExpNode = static_cast<LorExpNode*>(node);
             if (!lorExpNode || lorExpNode->operands.empty()) return "";
-            return getExpType(lorExpNode->operands[0].get());
+            return getExpType(lorExpNode->operands[0]);
         }
         // 其他类型可以根据需要继续添加
         default:
@@ -800,7 +693,7 @@ vector<string> SemanticAnalyzer::getFuncRParamsTypes(FuncRParamsNode* node) {
     if (!node || node->params.empty()) return paramTypes;
 
     for (auto& param : node->params) {
-        paramTypes.push_back(getExpType(param.get()));
+        paramTypes.push_back(getExpType(param));
     }
 
     return paramTypes;
@@ -812,33 +705,32 @@ void SemanticAnalyzer::analyzeFuncRParams(FuncRParamsNode* node) {
     // 检查函数实参的语义
     //c:未定义
     //cout<<"实参函数名:"<<node->name<<endl;
-    if (symbolTable.Isundefined(node->name,funcLevel)) {
+    if (symbolTable.Isundefined(node->name)) {
         reportError(node->linenum, "c");
     } else {
         //d:参数个数不匹配
         vector<string>param_types = getFuncRParamsTypes(node);
         auto entry = symbolTable.lookup(node->name);
         if(param_types.size() != entry->paramTypes.size()){
-            cout<<"实参params is "<<param_types.size()<<endl;
-            cout<<"形参params is "<<entry->paramTypes.size()<<endl;
+            TRACE(TRACE_DETAIL, "实参params is " << param_types.size() << " 形参params is " << entry->paramTypes.size());
             reportError(node->linenum,"d");
         } else {
             //e:参数类型不匹配
             if(param_types.size()!=0 && entry->paramTypes.size()!=0){
-                for(int i=0;i<param_types.size();++i){
+                for(size_t i=0;i<param_types.size();++i){
                     if(param_types[i] != entry->paramTypes[i] && param_types[i] != "Const"+entry->paramTypes[i]){
                         if(param_types[i] == "Void"){
-                            cout<<"实参:"<<param_types[i]<<" 形参:"<<entry->paramTypes[i]<<endl;
+                            TRACE(TRACE_DETAIL, "实参:" << param_types[i] << " 形参:" << entry->paramTypes[i]);
                             reportError(node->linenum,"e");
                             break;
                         }
                         if(param_types[i].find("Array")!=string::npos&&entry->paramTypes[i].find("Array")==string::npos){
-                            cout<<"实参:"<<param_types[i]<<" 形参:"<<entry->paramTypes[i]<<endl;
+                            TRACE(TRACE_DETAIL, "实参:" << param_types[i] << " 形参:" << entry->paramTypes[i]);
                             reportError(node->linenum,"e");
                             break;
                         }
                         else if(param_types[i].find("Array")==string::npos&&entry->paramTypes[i].find("Array")!=string::npos){
-                            cout<<"实参:"<<param_types[i]<<" 形参:"<<entry->paramTypes[i]<<endl;
+                            TRACE(TRACE_DETAIL, "实参:" << param_types[i] << " 形参:" << entry->paramTypes[i]);
                             reportError(node->linenum,"e");
                             break;
                         }
@@ -849,274 +741,64 @@ void SemanticAnalyzer::analyzeFuncRParams(FuncRParamsNode* node) {
     }
     
     for(auto& paramsnode : node->params){
-        traverseAST(paramsnode.get());
+        traverseAST(paramsnode);
     }
-    /*生成中间代码*/
-    func_call(node->name);
 }
 
 void SemanticAnalyzer::analyzeMulExp(MulExpNode* node) {
     if (!node) return;
-    for (int i = 0; i<node->operands.size();i++){
-        traverseAST(node->operands[i].get());
-        if (i > 0) {
-            switch (node->operators[i - 1]) {
-                case MULT:
-                    codeOutput << "MULT" << endl;
-                    break;
-                case DIV:
-                    codeOutput << "DIV" << endl;
-                    break;
-                case MOD:
-                    codeOutput << "MOD" << endl;
-                    break;
-                default:
-                    break;
-            }
-        }
+    for (auto& operand : node->operands) {
+        traverseAST(operand);
     }
 }
 
 void SemanticAnalyzer::analyzeAddExp(AddExpNode* node) {
     if (!node) return;
-    for (int i = 0; i<node->operands.size();i++){
-        traverseAST(node->operands[i].get());
-        if (i > 0) {
-            switch (node->operators[i - 1]) {
-                case PLUS:
-                    codeOutput << "ADD" << endl;
-                    break;
-                case MINU:
-                    codeOutput << "SUB" << endl;
-                    break;
-                default:
-                    break;
-            }
-        }
+    for (auto& operand : node->operands) {
+        traverseAST(operand);
     }
 }
 
 void SemanticAnalyzer::analyzeRelExp(RelExpNode* node) {
     if (!node) return;
-    // 检查关系表达式的语义
-    for (size_t i = 0; i < node->operands.size(); ++i) {
-        traverseAST(node->operands[i].get());
-        if (i > 0) {
-            switch (node->operators[i - 1]) {
-                case LSS:
-                    codeOutput << "LT" << endl;
-                    break;
-                case GRE:
-                    codeOutput << "GT" << endl;
-                    break;
-                case LEQ:
-                    codeOutput << "LE" << endl;
-                    break;
-                case GEQ:
-                    codeOutput << "GE" << endl;
-                    break;
-                default:
-                    break;
-            }
-        }
+    for (auto& operand : node->operands) {
+        traverseAST(operand);
     }
 }
 
 void SemanticAnalyzer::analyzeEqExp(EqExpNode* node) {
     if (!node) return;
-    // 检查相等性表达式的语义
-    for (size_t i = 0; i < node->operands.size(); ++i) {
-        traverseAST(node->operands[i].get());
-        if (i > 0) {
-            switch (node->operators[i - 1]) {
-                case EQL:
-                    codeOutput << "EQ" << endl;
-                    break;
-                case NEQ:
-                    codeOutput << "NE" << endl;
-                    break;
-                default:
-                    break;
-            }
-        }
+    for (auto& operand : node->operands) {
+        traverseAST(operand);
     }
 }
 
 void SemanticAnalyzer::analyzeLandExp(LandExpNode* node) {
     if (!node) return;
-    // 检查逻辑与表达式的语义
-    /*需要在这里处理短路求值问题*/
-    int tmp = 0;
-    if(node->operands.size()>=2)
-        tmp = ++shortvalorder;
+    // 检查逻辑与表达式的语义，短路求值由代码生成处理
     for (size_t i = 0; i < node->operands.size(); ++i) {
-        //printAST(node->operands[i].get());
-        cout<<node->operands[i].get()->type<<endl;
-        /*短路求值*/
-        traverseAST(node->operands[i].get());
-        if (i > 0) {
-            codeOutput << "AND" << endl;
-        }
-        if(node->operands.size()>=2){
-            shortjumpiffalse_pcode(tmp);
-        }
+        TRACE(TRACE_DETAIL, "operand type " << node->operands[i]->type);
+        traverseAST(node->operands[i]);
     }
-    if(node->operands.size()>=2)
-        shortlabel(tmp);
 }
 
 void SemanticAnalyzer::analyzeLorExp(LorExpNode* node) {
     if (!node) return;
-    // 检查逻辑或表达式的语义
-    int tmp = 0;
-    if(node->operands.size()>=2)
-        tmp = ++shortvalorder;
+    // 检查逻辑或表达式的语义，短路求值由代码生成处理
     for (size_t i = 0; i < node->operands.size(); ++i) {
-        cout<<node->operands[i].get()->type<<endl;
-        traverseAST(node->operands[i].get());
-        if (i > 0) {
-            codeOutput << "OR" << endl;
-        }
-        if(node->operands.size()>=2){
-            shortjumpiftrue_pcode(tmp);
-        }
+        TRACE(TRACE_DETAIL, "operand type " << node->operands[i]->type);
+        traverseAST(node->operands[i]);
     }
-    if(node->operands.size()>=2)
-        shortlabel(tmp);
 }
 
 void SemanticAnalyzer::analyzeNumber(NumberNode* node) {
     if (!node) return;
-    // 检查数值的语义
-    switch (node->type) {
-        case NODE_NUMBER:
-            codeOutput<<"PUSH"<<" "<<node->value<<endl;
-            /*短路求值*/
-            break;
-        // 其他数值类型
-    }
-}
-
-int getCharConstAscii(const string& charConst) {
-    // 检查字符常量的长度是否为 1, 2, 3 或 4
-    if (charConst.length() != 1 && charConst.length() != 2 && charConst.length() != 3 && charConst.length() != 4) {
-        cerr << "Invalid CharConst: " << charConst << ". Expected format: 'c', '\\x', 'c', or '\\x'." << endl;
-        return -1; // 返回 -1 表示错误
-    }
-
-    // 如果是长度为 1 的字符串（不带单引号）
-    if (charConst.length() == 1) {
-        char c = charConst[0];
-        // 检查字符是否在 32-126 范围内
-        if (c >= 32 && c <= 126 || c == 10) {
-            return static_cast<int>(c); // 返回字符的 ASCII 码
-        } else {
-            cerr << "Invalid CharConst: " << charConst << ". Character must be in range 32-126." << endl;
-            return -1;
-        }
-    }
-
-    // 如果是长度为 2 的字符串（转义字符，不带单引号）
-    if (charConst.length() == 2) {
-        // 检查是否以反斜杠开头
-        if (charConst[0] != '\\') {
-            cerr << "Invalid CharConst: " << charConst << ". Escape sequence must start with '\\'." << endl;
-            return -1;
-        }
-
-        // 转义字符映射表
-        unordered_map<char, int> escapeMap = {
-            {'a', 7},   // 响铃
-            {'b', 8},   // 退格
-            {'t', 9},   // 制表符
-            {'n', 10},  // 换行
-            {'v', 11},  // 垂直制表符
-            {'f', 12},  // 换页
-            {'r', 13},  // 回车
-            {'\\', 92}, // 反斜杠
-            {'\'', 39}, // 单引号
-            {'\"', 34}, // 双引号
-            {'0', 0}    // 空字符
-        };
-
-        char escapeChar = charConst[1];
-        if (escapeMap.find(escapeChar) != escapeMap.end()) {
-            return escapeMap[escapeChar]; // 返回转义字符的 ASCII 码
-        } else {
-            cerr << "Invalid escape sequence: " << charConst << ". Unknown escape character: " << escapeChar << endl;
-            return -1;
-        }
-    }
-
-    // 如果是普通字符（长度为 3）
-    if (charConst.length() == 3) {
-        // 检查字符常量是否以单引号开头和结尾
-        if (charConst[0] != '\'' || charConst[2] != '\'') {
-            cerr << "Invalid CharConst: " << charConst << ". Must start and end with single quotes." << endl;
-            return -1;
-        }
-
-        char c = charConst[1];
-        // 检查字符是否在 32-126 范围内
-        if (c >= 32 && c <= 126) {
-            return static_cast<int>(c); // 返回字符的 ASCII 码
-        } else {
-            cerr << "Invalid CharConst: " << charConst << ". Character must be in range 32-126." << endl;
-            return -1;
-        }
-    }
-
-    // 如果是转义字符（长度为 4）
-    if (charConst.length() == 4) {
-        // 检查字符常量是否以单引号开头和结尾
-        if (charConst[0] != '\'' || charConst[3] != '\'') {
-            cerr << "Invalid CharConst: " << charConst << ". Must start and end with single quotes." << endl;
-            return -1;
-        }
-
-        // 检查是否以反斜杠开头
-        if (charConst[1] != '\\') {
-            cerr << "Invalid CharConst: " << charConst << ". Escape sequence must start with '\\'." << endl;
-            return -1;
-        }
-
-        // 转义字符映射表
-        unordered_map<char, int> escapeMap = {
-            {'a', 7},   // 响铃
-            {'b', 8},   // 退格
-            {'t', 9},   // 制表符
-            {'n', 10},  // 换行
-            {'v', 11},  // 垂直制表符
-            {'f', 12},  // 换页
-            {'r', 13},  // 回车
-            {'\\', 92}, // 反斜杠
-            {'\'', 39}, // 单引号
-            {'\"', 34}, // 双引号
-            {'0', 0}    // 空字符
-        };
-
-        char escapeChar = charConst[2];
-        if (escapeMap.find(escapeChar) != escapeMap.end()) {
-            return escapeMap[escapeChar]; // 返回转义字符的 ASCII 码
-        } else {
-            cerr << "Invalid escape sequence: " << charConst << ". Unknown escape character: " << escapeChar << endl;
-            return -1;
-        }
-    }
-
-    return -1; // 默认返回错误
+    // 数值没有需要检查的语义
 }
 
-
 void SemanticAnalyzer::analyzeCharacter(CharacterNode* node) {
     if (!node) return;
-    // 检查字符的语义
-    switch (node->type) {
-        case NODE_CHARACTER:
-            codeOutput<<"PUSH"<<" "<<getCharConstAscii(node->value)<<endl;
-            break;
-        // 其他字符类型
-    }
+    // 字符没有需要检查的语义
 }
 
 void SemanticAnalyzer::analyzeConstExp(ConstExpNode* node) {
@@ -1128,30 +810,16 @@ void SemanticAnalyzer::analyzeConstExp(ConstExpNode* node) {
 void SemanticAnalyzer::analyzeFor(ForNode* node) {
     if (!node) return;
     // 检查for语句的语义
-    labelfor_bk_ctn ++;
-    int tmp = labelfor_bk_ctn;
-    break_continu = tmp;
-    //for{}里的作用域
     if (node->init){
-        analyzeSmallfor(static_cast<SmallforstmtNode*>(node->init.get()));
+        analyzeSmallfor(static_cast<SmallforstmtNode*>(node->init));
     } 
-    label("FOR_START",tmp);
     if (node->forcond) {
-        analyzeLorExp(static_cast<LorExpNode*>(node->forcond.get()));
-        jumpiffalse_pcode("FOR_END",tmp);
+        analyzeLorExp(static_cast<LorExpNode*>(node->forcond));
     }
-        
-    traverseAST(static_cast<StmtNode*>(node->body.get()));
-    //cout<<"tmp is "<<tmp<<endl;
-    label("CONTINUE",tmp);
-
+    traverseAST(static_cast<StmtNode*>(node->body));
     if (node->step) {
-        analyzeSmallfor(static_cast<SmallforstmtNode*>(node->step.get()));
+        analyzeSmallfor(static_cast<SmallforstmtNode*>(node->step));
     }
-    jump_pcode("FOR_START",tmp);
-    label("BREAK",tmp);
-    label("FOR_END",tmp);
-    break_continu --;
 }
 
 void SemanticAnalyzer::analyzeSmallfor(SmallforstmtNode* node) {
@@ -1159,18 +827,18 @@ void SemanticAnalyzer::analyzeSmallfor(SmallforstmtNode* node) {
     // 检查for语句的语义
     
     if (node->exp){
-        auto lvalnode = static_cast<LValNode*>(node->lval.get());
+        auto lvalnode = static_cast<LValNode*>(node->lval);
         auto lvalentry = symbolTable.lookup(lvalnode->name);
         if(lvalentry){
             if(lvalentry->type.find("Const")!=string::npos){
                 reportError(lvalnode->linenum,"h");
             }
         }
-        analyzeAddExp(static_cast<AddExpNode*>(node->exp.get()));
+        analyzeAddExp(static_cast<AddExpNode*>(node->exp));
     }
     //先右后左
     if (node->lval)
-        analyzeLVal(static_cast<LValNode*>(node->lval.get()),true);
+        analyzeLVal(static_cast<LValNode*>(node->lval));
         
 }
 
@@ -1180,24 +848,8 @@ void SemanticAnalyzer::analyzeReturnStmt(ReturnStmtNode* node) {
     //cout << "Analyzing ReturnStmtNode" << endl;
     // 你可以在这里添加更多的语义检查逻辑
     if (node->exp) {
-        traverseAST(node->exp.get());
+        traverseAST(node->exp);
     }
-    if(return_pop_varsparams.size()){
-        for(auto it: return_pop_varsparams){
-            pop_var(it);
-        }
-    }
-    if(return_pop_varsin.size()){
-        for(auto it: return_pop_varsin){
-            pop_var(it);
-        }
-    }
-    if(node->exp) {
-        return_pcode();
-    }else{
-        returnnull_pcode();
-    }
-
 }
 
 void SemanticAnalyzer::analyzeBreakStmt(BreakStmtNode* node) {
@@ -1205,7 +857,6 @@ void SemanticAnalyzer::analyzeBreakStmt(BreakStmtNode* node) {
     // 检查 break 语句的语义
     //cout << "Analyzing BreakStmtNode" << endl;
     // 你可以在这里添加更多的语义检查逻辑
-    break_pcode(break_continu);
 }
 
 void SemanticAnalyzer::analyzeContinueStmt(ContinueStmtNode* node) {
@@ -1213,13 +864,12 @@ void SemanticAnalyzer::analyzeContinueStmt(ContinueStmtNode* node) {
     // 检查 continue 语句的语义
     //cout << "Analyzing ContinueStmtNode" << endl;
     // 你可以在这里添加更多的语义检查逻辑
-    continue_pcode(break_continu);
 }
 //错误l
 bool checkPrintfFormatErr(PrintfStmtNode* printfStmtNode) {
     if (!printfStmtNode) return false;
-    string format = printfStmtNode->format;
-    vector<unique_ptr<ASTNode>>& args = printfStmtNode->args;
+    string_view format = printfStmtNode->format;
+    const AstList<ASTNode*>& args = printfStmtNode->args;
     int formatCount = 0;
     size_t pos = 0;
     // 查找 %d
@@ -1233,9 +883,8 @@ bool checkPrintfFormatErr(PrintfStmtNode* printfStmtNode) {
         formatCount++;
         pos += 2; // 跳过 "%c"
     }
-    if (formatCount != args.size()) {
-        cout << "formatcount: " << formatCount << " args num: " << args.size() << endl;
-        cout << printfStmtNode->format << endl;
+    if (formatCount != (int)args.size()) {
+        TRACE(TRACE_DETAIL, "formatcount: " << formatCount << " args num: " << args.size() << " " << printfStmtNode->format);
         return true;
     }
     return false;
@@ -1243,12 +892,11 @@ bool checkPrintfFormatErr(PrintfStmtNode* printfStmtNode) {
 void SemanticAnalyzer::analyzePrintfStmt(PrintfStmtNode* node) {
     if (!node) return;
     for (auto& arg : node->args) {
-        traverseAST(arg.get());
+        traverseAST(arg);
     }
     if(checkPrintfFormatErr(node)){
         reportError(node->printlinenum,"l");
     }
-    printf_pcode(node->format);
 }
 
 void SemanticAnalyzer::analyzeEmptyStmt(EmptyStmtNode* node) {
@@ -1264,18 +912,14 @@ void SemanticAnalyzer::analyzeAssignStmt(AssignStmtNode* node) {
     //cout << "Analyzing AssignStmtNode" << endl;
     // 你可以在这里添加更多的语义检查逻辑
     // 检查左值
-    auto lvalnode = static_cast<LValNode*>(node->lval.get());
+    auto lvalnode = static_cast<LValNode*>(node->lval);
     // 检查右值
     if (node->exp) {
-        traverseAST(static_cast<ExpNode*>(node->exp.get()));
-    } else if (node->getint){
-        codeOutput<<"GETINT"<<endl;
-    } else if (node->getchar){
-        codeOutput<<"GETCHAR"<<endl;
+        traverseAST(static_cast<ExpNode*>(node->exp));
     }
     //检查左值
     if (node->lval) {
-        analyzeLVal(lvalnode,true);
+        analyzeLVal(lvalnode);
     }
     auto entry = symbolTable.lookup(lvalnode->name);
     if (entry) {
@@ -1299,34 +943,21 @@ void SemanticAnalyzer::analyzeExpStmt(ExpStmtNode* node) {
     }
     */
     if (node->exp){ // && (!node->unable)) {
-        traverseAST(node->exp.get());
+        traverseAST(node->exp);
     }
 }
 
 void SemanticAnalyzer::analyzeIfStmt(IfStmtNode* node) {
     if (!node) return;
     // 检查 if 语句的语义
-    //cout << "Analyzing IfStmtNode" << endl;
-    // 检查条件表达式
-    if_order++;
-    int cur_if = if_order;
-    analyzeLorExp(static_cast<LorExpNode*>(node->ifcond.get()));
-    // 检查 else 分支
+    analyzeLorExp(static_cast<LorExpNode*>(node->ifcond));
+    traverseAST(node->thenStmt);//stmt
     if (node->elseStmt) {
-        jumpiffalse_pcode("ELSE",cur_if);
-        // 检查 then 分支
-        traverseAST(node->thenStmt.get());//stmt
-        jump_pcode("END_IF",cur_if);
-        label("ELSE",cur_if);
-        traverseAST(node->elseStmt.get());//stmt
-    } else {
-        jumpiffalse_pcode("END_IF",cur_if);
-        traverseAST(node->thenStmt.get());//stmt
+        traverseAST(node->elseStmt);//stmt
     }
-    label("END_IF",cur_if);
 }
 
 void SemanticAnalyzer::reportError(int linenum, const string& errorCode) {
     // 报告错误
-    errorOutput <<linenum <<" " << errorCode << endl;
+    errorLines.push_back(to_string(linenum) + " " + errorCode);
 }
\ No newline at end of file
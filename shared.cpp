@@ -53,17 +53,30 @@ void MergeErrors() {
     outputFile.close();
 }
 
+vector<string> mergeErrorLines(vector<string> lines) {
+    sort(lines.begin(), lines.end(), compareLines);
+    vector<string> merged;
+    unordered_set<string> seenLines;
+    for (auto& line : lines) {
+        if (seenLines.insert(line).second) {
+            merged.push_back(move(line));
+        }
+    }
+    return merged;
+}
+
 // 打印Token
-void PrintTokens(const vector<Token>& tokens) {
-    for (const auto& token : tokens) {
-        std::cout << tokenTypeMap[token.type] << " ";
-        std::cout << token.value << " ";
-        std::cout << token.lineNumber << std::endl;
+void PrintTokens(const TokenStream& tokens) {
+    for (size_t i = 0; i < tokens.size(); i++) {
+        std::cout << tokenTypeMap[tokens.type(i)] << " ";
+        std::cout << tokens.value(i) << " ";
+        std::cout << tokens.line(i) << std::endl;
     }
 }
 
 std::string replaceCommentsWithSpaces(const std::string& input) {
-    std::ostringstream output;
+    std::string output;
+    output.reserve(input.size());
     bool inComment = false;
 
     for (size_t i = 0; i < input.size(); ++i) {
@@ -81,12 +94,12 @@ std::string replaceCommentsWithSpaces(const std::string& input) {
                 }
                 // 如果遇到换行符，保留换行符
                 if (i < input.size()) {
-                    output << '\n';
+                    output += '\n';
                 }
             }
             // 复制非注释字符
             else {
-                output << input[i];
+                output += input[i];
             }
         } else {
             // 检测块注释结束
@@ -97,15 +110,15 @@ std::string replaceCommentsWithSpaces(const std::string& input) {
             // 处理块注释内容
             else {
                 if (input[i] == '\n') {
-                    output << '\n'; // Preserve newlines
+                    output += '\n'; // Preserve newlines
                 } else {
-                    output << ' '; // Replace other characters with spaces
+                    output += ' '; // Replace other characters with spaces
                 }
             }
         }
     }
 
-    return output.str();
+    return output;
 }
 
 void processFile(const std::string& inputFileName, const std::string& outputFileName) {
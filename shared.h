@@ -19,9 +19,13 @@ bool compareLines(const string& line1, const string& line2);
 // 合并错误
 void MergeErrors();
 
+// 合并内存中的错误：按行号排序并去重，与 MergeErrors + deduplicateLines 的结果相同
+vector<string> mergeErrorLines(vector<string> lines);
+
 // 打印Token
-void PrintTokens(const vector<Token>& tokens);
+void PrintTokens(const TokenStream& tokens);
 
+// 注释换成空格、保留换行；编译时注释由词法分析直接跳过，这两个函数只用于写出去注释后的文本（--dump-stripped）
 std::string replaceCommentsWithSpaces(const std::string& input);
 
 void processFile(const std::string& inputFileName, const std::string& outputFileName);
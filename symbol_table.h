@@ -1,16 +1,19 @@
 #ifndef SYMBOL_TABLE_H
 #define SYMBOL_TABLE_H
 
-#include <unordered_map>
+#include <deque>
 #include <vector>
 #include <string>
+#include "interner.h"
 
 using namespace std;
 
-const int smb_size =150;
+class ConstDefNode;
+
+const int global_level = 1; // 全局作用域的序号
 
 struct SymbolEntry {
-    string name;
+    IdentId name; //identifiers 中的编号
     string type;
     int order;
     bool isConst = false; // 默认值为 false
@@ -18,25 +21,80 @@ struct SymbolEntry {
     bool isArray = false; // 默认值为 false
     vector<string> paramTypes = {}; // 函数参数类型
     int scopeLevel = 0; // 默认值为 0
+    int slot = -1; // 变量在全局区或函数帧中的槽位
+    SymbolEntry* shadowed = nullptr; // 被本条目遮住的外层同名条目
+    const ConstDefNode* constDef = nullptr; // 常量的定义结点，供常量传播
+};
+
+/*关闭的作用域中的符号只留下输出符号表要用的部分*/
+struct ClosedSymbol {
+    int scopeLevel;
+    int order;
+    IdentId name;
+    string type;
 };
 
+/*
+ * visible[名字] 指向该名字当前可见的最内层条目，条目经 shadowed 连到被遮住的外层同名条目。
+ * 每个打开的作用域在 undoLog 中记录自己添加的条目，退出时按相反顺序把 visible 恢复成 shadowed。
+ * 查找、重定义检查和退出作用域都不用遍历作用域或表项，均摊 O(1)。
+ * 作用域只是 openScopes 中的一项，个数和深度不设上限；条目从 entryPool 分配，
+ * 作用域关闭后条目归还 freeEntries 复用，只把名字、类型和序号留在 closedSymbols 中供输出。
+ */
 class SymbolTable {
 public:
+    SymbolTable() = default;
+    SymbolTable(const SymbolTable&) = delete; // visible 和 undoLog 指向 entryPool
+    SymbolTable& operator=(const SymbolTable&) = delete;
   
+    /*进入序号为 num 的作用域；与当前作用域相同时不新开（形参和函数体共用一个作用域）*/
     void enterScope(int num) {
-        currentScopeLevel = num;
+        if (num != currentScopeLevel) {
+            openScopes.push_back({currentScopeLevel, undoLog.size()});
+            currentScopeLevel = num;
+        }
     }
 
+    /*退回到外层序号为 num 的作用域，途中的作用域都关闭*/
     void exitScope(int num) {
-        currentScopeLevel = num;
+        while (currentScopeLevel != num && !openScopes.empty()) {
+            OpenScope scope = openScopes.back();
+            openScopes.pop_back();
+            for (size_t i = undoLog.size(); i > scope.undoStart; --i) {
+                SymbolEntry* entry = undoLog[i - 1];
+                visible[entry->name] = entry->shadowed;
+                closedSymbols.push_back({entry->scopeLevel, entry->order, entry->name, move(entry->type)});
+                freeEntries.push_back(entry);
+            }
+            undoLog.resize(scope.undoStart);
+            currentScopeLevel = scope.outerLevel;
+        }
     }
 
     void addSymbol(const SymbolEntry& entry) {
-        SymbolEntry newEntry = entry; // 创建一个新的 SymbolEntry 对象
-        newEntry.scopeLevel = currentScopeLevel; // 设置作用域序号
-        newEntry.order = declorder++;
-        scopeStack[currentScopeLevel][newEntry.name] = newEntry; // 添加到符号表
-        lastAddedSymbol = newEntry; // 记录最后一个添加的符号
+        SymbolEntry* newEntry = Isrepeated(entry.name) ? visible[entry.name] : nullptr;
+        if (newEntry) {
+            SymbolEntry* shadowed = newEntry->shadowed;
+            *newEntry = entry; // 同一作用域重复添加时覆盖，遮蔽链不变
+            newEntry->shadowed = shadowed;
+        } else {
+            if (freeEntries.empty()) {
+                newEntry = &entryPool.emplace_back(entry);
+            } else {
+                newEntry = freeEntries.back();
+                freeEntries.pop_back();
+                *newEntry = entry;
+            }
+            if (entry.name >= visible.size()) {
+                visible.resize(entry.name + 1, nullptr);
+            }
+            newEntry->shadowed = visible[entry.name];
+            visible[entry.name] = newEntry;
+            undoLog.push_back(newEntry);
+        }
+        newEntry->scopeLevel = currentScopeLevel; // 设置作用域序号
+        newEntry->order = declorder++;
+        lastAddedSymbol = *newEntry; // 记录最后一个添加的符号
     }
 
     void insertparamtypes(const SymbolEntry& entry){
@@ -44,43 +102,17 @@ public:
         thentry->paramTypes = entry.paramTypes;
     }
 
-    bool Isrepeated(const string& name) {//b
-        for (auto it : scopeStack[currentScopeLevel]) {
-            if (it.first == name) {
-                return true;
-            }
-        }
-        return false;
+    bool Isrepeated(IdentId name) {//b
+        SymbolEntry* entry = lookup(name);
+        return entry && entry->scopeLevel == currentScopeLevel;
     }
 
-    bool Isundefined(const string& name,int funclevel) {//c
-        //cout<<"funclevel: "<<funclevel<<endl;
-        for (auto it : scopeStack[1]) {
-            if (it.first == name) {
-                //cout<<"c: "<<it.first<<" "<<it.second.scopeLevel<<endl;
-                return false;
-            }
-        }
-        for (int level = funclevel; level <= currentScopeLevel; ++level) {
-            for (auto it : scopeStack[level]) {
-                if (it.first == name) {
-                    //cout<<"c: "<<it.first<<" "<<it.second.scopeLevel<<endl;
-                    return false;
-                }
-            }
-        }
-        return true;
+    bool Isundefined(IdentId name) {//c
+        return lookup(name) == nullptr;
     }
 
-    SymbolEntry* lookup(const string& name) {
-        for (int level = currentScopeLevel; level >=0; --level) {
-            for (auto& entry : scopeStack[level]) {
-                if (entry.first == name) {
-                    return &entry.second;
-                }
-            }
-        }
-        return nullptr;
+    SymbolEntry* lookup(IdentId name) {
+        return name < visible.size() ? visible[name] : nullptr;
     }
 
     int getCurrentLevel() const {
@@ -94,7 +126,17 @@ public:
     void dumpSymbolTable(const string& filename) const;
 
 private:
-    unordered_map<string, SymbolEntry> scopeStack[smb_size];
+    struct OpenScope {
+        int outerLevel;
+        size_t undoStart; // 本作用域在 undoLog 中的第一条
+    };
+
+    deque<SymbolEntry> entryPool; // 条目地址不随扩容改变
+    vector<SymbolEntry*> freeEntries;
+    vector<ClosedSymbol> closedSymbols;
+    vector<SymbolEntry*> visible; // 按名字编号下标，名字编号是稠密的
+    vector<OpenScope> openScopes;
+    vector<SymbolEntry*> undoLog; // 仍打开的作用域里的全部条目
     int currentScopeLevel = 0;
     SymbolEntry lastAddedSymbol; // 记录最后一个添加的符号
     int declorder = 0;
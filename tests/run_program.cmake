@@ -0,0 +1,29 @@
+# 在单独的目录里用 Compiler 编译并运行一个源程序，检查退出码，以及结果或错误输出
+# 参数：COMPILER SOURCE WORKDIR EXPECT_EXIT [ARGS] [EXPECT_RESULT] [EXPECT_ERROR]
+#   ARGS          传给 Compiler 的参数，以 ; 分隔
+#   EXPECT_RESULT pcoderesult.txt 应有的内容
+#   EXPECT_ERROR  stderr 应匹配的正则表达式
+file(REMOVE_RECURSE "${WORKDIR}")
+file(MAKE_DIRECTORY "${WORKDIR}")
+configure_file("${SOURCE}" "${WORKDIR}/testfile.txt" COPYONLY)
+
+execute_process(
+    COMMAND "${COMPILER}" ${ARGS}
+    WORKING_DIRECTORY "${WORKDIR}"
+    RESULT_VARIABLE exitCode
+    OUTPUT_QUIET
+    ERROR_VARIABLE errorOutput
+)
+
+if(NOT exitCode STREQUAL EXPECT_EXIT)
+    message(FATAL_ERROR "exit code ${exitCode}, expected ${EXPECT_EXIT}\n${errorOutput}")
+endif()
+if(DEFINED EXPECT_ERROR AND NOT errorOutput MATCHES "${EXPECT_ERROR}")
+    message(FATAL_ERROR "stderr does not match '${EXPECT_ERROR}':\n${errorOutput}")
+endif()
+if(DEFINED EXPECT_RESULT)
+    file(READ "${WORKDIR}/pcoderesult.txt" result)
+    if(NOT result STREQUAL EXPECT_RESULT)
+        message(FATAL_ERROR "pcoderesult.txt is '${result}', expected '${EXPECT_RESULT}'")
+    endif()
+endif()
@@ -0,0 +1,17 @@
+#include "trace.h"
+
+ofstream* traceSink = nullptr;
+
+bool openTrace(const string& filename) {
+    if (compiledTraceLevel == TRACE_OFF) {
+        return false;
+    }
+    closeTrace();
+    traceSink = new ofstream(filename);
+    return true;
+}
+
+void closeTrace() {
+    delete traceSink;
+    traceSink = nullptr;
+}
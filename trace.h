@@ -0,0 +1,41 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <fstream>
+#include <string>
+
+using namespace std;
+
+/*
+ * 调试跟踪
+ * 级别在编译期由 COMPILER_TRACE_LEVEL 决定，高于它的 TRACE 整条被 if constexpr 丢弃，发布构建没有任何开销；
+ * 编进来的跟踪还要在运行时用 --trace 打开，输出写到单独的文件，不混进 stdout
+ */
+#ifndef COMPILER_TRACE_LEVEL
+#define COMPILER_TRACE_LEVEL 0
+#endif
+
+enum TraceLevel {
+    TRACE_OFF = 0,
+    TRACE_PHASE = 1, //各阶段的概要
+    TRACE_DETAIL = 2, //每条语句/指令
+};
+
+constexpr int compiledTraceLevel = COMPILER_TRACE_LEVEL;
+
+/*跟踪输出，未打开时为nullptr*/
+extern ofstream* traceSink;
+
+/*打开跟踪输出；编译期级别为0时返回false*/
+bool openTrace(const string& filename);
+void closeTrace();
+
+#define TRACE(level, message) do { \
+        if constexpr ((level) <= compiledTraceLevel) { \
+            if (traceSink) { \
+                *traceSink << message << '\n'; \
+            } \
+        } \
+    } while (0)
+
+#endif // TRACE_H